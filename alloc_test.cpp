@@ -0,0 +1,69 @@
+// Enforces that rendering with a reused Session into a pre-sized string does not allocate (in steady state).
+#include "template_engine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static size_t allocs = 0;
+
+void *operator new(size_t size)
+{
+  allocs++;
+  void *ret = malloc(size ? size : 1);
+  if (!ret) {
+    throw std::bad_alloc();
+  }
+  return ret;
+}
+
+void operator delete(void *ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  free(ptr);
+}
+
+int main()
+{
+  auto tmpl = Template::Engine::fromString("\t  head $a $(opt $ml $nope$)\n  $[g{, }\n    <$a:${n:fixed2}>$]\n$(opt $x$)\nend $ml\n");
+
+  Template::Data ks = {
+    {"a", "A"},
+    {"ml", "m1\nm2\nm3"}
+  };
+  ks.add_list("g", { {"a", "x"}, {"n", 3} });
+  ks.add_list("g", { {"a", "y"}, {"n", 2.5} });
+
+  Template::Engine::Session session;
+  std::string out;
+  out.reserve(4096);
+
+  size_t failed = 0;
+  for (int round = 0; round < 5; round++) {  // (round 0: warm up)
+    const size_t before = allocs;
+
+    out.clear();
+    tmpl.renderTo(out, ks, &session);
+
+    out.clear();
+    tmpl.renderTo(out, {
+      {"a", "A"},
+      {"ml", "a\nb"},
+      {"x", "X"},
+      {"g", {
+        { {"a", "q"}, {"n", 1} }
+      }}
+    }, &session);
+
+    if (round > 0 && allocs != before) {
+      printf("round %d: %zu allocations\n", round, allocs - before);
+      failed++;
+    }
+  }
+
+  printf("%s\n", (failed) ? "alloc_test: FAILED" : "alloc_test: ok");
+  return (failed) ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+// Compares parse_json_string (JSON -> Data directly) with the two-step path (JSON -> DOM -> Data) on a multi-megabyte payload.
+// (the DOM is built from the same tokenizer, so the difference is the intermediate DOM + second walk)
+#include "template_engine.h"
+#include "template_json.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct dom_t {
+  enum struct type_e { null, string, number, boolean, object, array };
+  type_e type = type_e::null;
+  std::string string;  // string / number (raw) / boolean
+  std::vector<std::pair<std::string, dom_t>> object;
+  std::vector<dom_t> array;
+};
+
+class DomBuilder : public Template::detail::JsonHandler {
+public:
+  dom_t root;
+
+  void begin_object() override {
+    push(dom_t::type_e::object);
+  }
+  void key(std::string_view key) override {
+    next_key = key;
+  }
+  void end_object() override {
+    stack.pop_back();
+  }
+
+  void begin_array() override {
+    push(dom_t::type_e::array);
+  }
+  void end_array() override {
+    stack.pop_back();
+  }
+
+  void string(std::string_view value) override {
+    add(dom_t::type_e::string).string = value;
+  }
+  void number(std::string_view raw) override {
+    add(dom_t::type_e::number).string = raw;
+  }
+  void boolean(bool value) override {
+    add(dom_t::type_e::boolean).string = (value) ? "true" : "false";
+  }
+  void null() override {
+    add(dom_t::type_e::null);
+  }
+
+private:
+  dom_t &add(dom_t::type_e type) {
+    dom_t *ret;
+    if (stack.empty()) {
+      ret = &root;
+    } else if (stack.back()->type == dom_t::type_e::object) {
+      ret = &stack.back()->object.emplace_back(std::move(next_key), dom_t()).second;
+    } else {
+      ret = &stack.back()->array.emplace_back();
+    }
+    ret->type = type;
+    return *ret;
+  }
+
+  void push(dom_t::type_e type) {
+    stack.push_back(&add(type));
+  }
+
+  std::vector<dom_t *> stack;
+  std::string next_key;
+};
+
+// same mapping as parse_json_string
+Template::Data to_data(const dom_t &obj)
+{
+  Template::Data ret({});
+  for (const auto &[key, value] : obj.object) {
+    switch (value.type) {
+    case dom_t::type_e::null:
+      break;
+    case dom_t::type_e::string:
+    case dom_t::type_e::number:
+    case dom_t::type_e::boolean:
+      ret.set(key, value.string);
+      break;
+    case dom_t::type_e::object:
+      ret.add_list(key, to_data(value));
+      break;
+    case dom_t::type_e::array:
+      ret.set(key, Template::List({}));
+      for (const auto &item : value.array) {
+        if (item.type == dom_t::type_e::object) {
+          ret.add_list(key, to_data(item));
+        }
+      }
+      break;
+    }
+  }
+  return ret;
+}
+
+std::string make_payload(size_t rows)
+{
+  std::string ret = R"({"title": "Catalog", "count": )" + std::to_string(rows) + R"(, "rows": [)";
+  for (size_t i = 0; i < rows; i++) {
+    ret.append((i) ? ",\n" : "\n")
+       .append(R"({"id": )").append(std::to_string(i))
+       .append(R"(, "name": "item \")").append(std::to_string(i))
+       .append(R"(\" with a reasonably long description text", "price": )").append(std::to_string(i % 1000)).append(".99")
+       .append(R"(, "active": )").append((i % 3) ? "true" : "false")
+       .append(R"(, "note": null, "vendor": {"name": "vendor )").append(std::to_string(i % 17)).append(R"(", "country": "DE"}})");
+  }
+  ret.append("]}\n");
+  return ret;
+}
+
+template <typename Fn>
+double best_of(int runs, Fn &&fn)
+{
+  double best = 1e99;
+  for (int i = 0; i < runs; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  const size_t rows = (argc > 1) ? std::stoul(argv[1]) : 50000;
+  const std::string json = make_payload(rows);
+  const double mb = json.size() / (1024.0 * 1024.0);
+
+  auto tmpl = Template::Engine::fromString("$title $count\n$[rows\n$id $name $price $active $[vendor $name/$country$]$]\n");
+
+  // (sanity check: both paths must produce the same data)
+  std::string direct_out, twostep_out;
+  {
+    DomBuilder dom;
+    Template::detail::parse_json(json, dom);
+    direct_out = tmpl.toString(Template::parse_json_string(json));
+    twostep_out = tmpl.toString(to_data(dom.root));
+  }
+  if (direct_out != twostep_out) {
+    fprintf(stderr, "json_bench: outputs differ\n");
+    return 1;
+  }
+
+  const double direct = best_of(5, [&json]() {
+    Template::Data data = Template::parse_json_string(json);
+  });
+  const double twostep = best_of(5, [&json]() {
+    DomBuilder dom;
+    Template::detail::parse_json(json, dom);
+    Template::Data data = to_data(dom.root);
+  });
+
+  printf("payload: %.1f MB (%zu rows)\n", mb, rows);
+  printf("parse_json_string:  %8.2f ms  %7.1f MB/s\n", direct * 1e3, mb / direct);
+  printf("JSON -> DOM -> Data: %7.2f ms  %7.1f MB/s\n", twostep * 1e3, mb / twostep);
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Checks rendering results (output + warnings) of optionals, i.e. that speculative rendering behaves like the check-first one.
+#include "template_engine.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+// stderr of fn
+template <typename Fn>
+std::string capture_stderr(Fn &&fn)
+{
+  fflush(stderr);
+  FILE *tmp = tmpfile();
+  const int saved = dup(2);
+  dup2(fileno(tmp), 2);
+  fn();
+  fflush(stderr);
+  dup2(saved, 2);
+  close(saved);
+
+  std::string ret;
+  rewind(tmp);
+  char buf[256];
+  for (size_t len; (len = fread(buf, 1, sizeof(buf), tmp)) > 0; ) {
+    ret.append(buf, len);
+  }
+  fclose(tmp);
+  return ret;
+}
+
+size_t failed = 0;
+
+void check(const char *name, const char *tmpl, const Template::detail::map_init_t &map, const std::string &expect_out, const std::string &expect_err)
+{
+  std::string out, err;
+  try {
+    err = capture_stderr([&]() {
+      out = Template::Engine::fromString(tmpl).toString(map);
+    });
+  } catch (std::exception &e) {
+    err.append("Exception: ").append(e.what()).append("\n");
+  }
+  if (out != expect_out || err != expect_err) {
+    printf("%s: FAILED\n  output: [%s]\n  expected: [%s]\n  warnings: [%s]\n  expected: [%s]\n",
+           name, out.c_str(), expect_out.c_str(), err.c_str(), expect_err.c_str());
+    failed++;
+  }
+}
+
+} // namespace
+
+int main()
+{
+  Template::List list = {
+    { {"y", "1"} }
+  };
+
+  check("skipped optional with type mismatch", "[$( $l $missing $)]\n",
+        { {"l", list} },
+        "[]\n", "");
+
+  check("type mismatch in rendered optional", "[$( $l $x $)]\n",
+        { {"l", list}, {"x", "X"} },
+        "", "Exception: Expected String, got List for variable 'l'\n");
+
+  check("no warnings from skipped optional", "<$( $[g,$zz$] $missing $)>\n",
+        { {"g", { { {"a", "1"} } }} },
+        "<>\n", "");
+
+  check("warnings from rendered optional", "<$( $[g,$zz$] $x $)>\n",
+        { {"g", { { {"a", "1"} } }}, {"x", "X"} },
+        "<  X >\n", "Warning: Variable 'zz' not found\n");
+
+  check("nested optional rethrows, outer skips", "ab$(cd $(ef $l$) $missing$)$ml $nope\n",
+        { {"l", list}, {"ml", "1\n2"} },
+        "ab1\n  2 \n", "Warning: Variable 'nope' not found\n");
+
+  printf("%s\n", (failed) ? "render_test: FAILED" : "render_test: ok");
+  return (failed) ? 1 : 0;
+}
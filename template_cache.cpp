@@ -0,0 +1,199 @@
+#include "template_cache.h"
+#include "template_input.h"
+#include <system_error>
+#include <stdexcept>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+namespace Template {
+
+namespace {
+constexpr const char magic[8] = { 'T', 'M', 'P', 'L', 'C', 'A', 'C', 'H' };
+constexpr const uint32_t format_version = 3;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;           // 0x01020304 (native)
+  uint64_t checksum;         // over header (with checksum = 0) + everything after it
+  uint64_t source_size;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+  uint32_t part_count;       // total (recursive)
+  uint32_t root_count;       // top-level
+  uint32_t pool_size;
+  uint32_t parser_version;   // cf. template_parser.h
+};
+
+struct flat_part_t {
+  uint32_t text_offset, text_size;
+  uint32_t modifiers_offset, modifiers_size;
+  uint32_t sub_count;        // direct children, following in pre-order
+  part_type_e type;
+  char unmerged_newline;
+  char pad[2];
+};
+
+static_assert(sizeof(header_t) == 64 && sizeof(flat_part_t) == 24, "unexpected padding");
+
+// (hdr.checksum itself is excluded)
+uint64_t checksum(header_t hdr, const char *body, size_t body_size, std::string_view more = {})
+{
+  hdr.checksum = 0;
+  const uint64_t ret = fnv1a(body, body_size, fnv1a((const char *)&hdr, sizeof(hdr)));
+  return fnv1a(more.data(), more.size(), ret);
+}
+
+bool stat_source(const char *sourcefile, header_t &hdr)
+{
+  struct stat st;
+  if (stat(sourcefile, &st) != 0) {
+    return false;
+  }
+  hdr.source_size = st.st_size;
+  hdr.source_mtime_sec = st.st_mtim.tv_sec;
+  hdr.source_mtime_nsec = st.st_mtim.tv_nsec;
+  return true;
+}
+
+uint32_t pool_add(std::string &pool, const std::string &str)
+{
+  if (pool.size() + str.size() > UINT32_MAX) {
+    throw std::length_error("template cache: string pool too large");
+  }
+  const uint32_t ret = pool.size();
+  pool.append(str);
+  return ret;
+}
+
+void flatten(const std::vector<part_t> &parts, std::vector<flat_part_t> &flat, std::string &pool)
+{
+  for (const auto &part : parts) {
+    flat_part_t fp = {};
+    fp.text_offset = pool_add(pool, part.text_name);
+    fp.text_size = part.text_name.size();
+    fp.modifiers_offset = pool_add(pool, part.modifiers_joiner);
+    fp.modifiers_size = part.modifiers_joiner.size();
+    fp.sub_count = part.sub.size();
+    fp.type = part.type;
+    fp.unmerged_newline = part.unmerged_newline;
+    flat.push_back(fp);
+    flatten(part.sub, flat, pool);
+  }
+}
+
+class Unflatten {
+public:
+  Unflatten(const flat_part_t *flat, size_t count, std::string_view pool)
+    : flat(flat), count(count), pool(pool) { }
+
+  // false on bad data
+  bool run(std::vector<part_t> &ret, size_t n, unsigned int depth = 0) {
+    if (depth > 1000 || n > count - pos) {  // (before reserving)
+      return false;
+    }
+    ret.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      if (pos >= count) {
+        return false;
+      }
+      const flat_part_t &fp = flat[pos++];
+      if ((uint8_t)fp.type > (uint8_t)part_type_e::group ||  // (type_e is char-based, i.e. possibly signed)
+          fp.text_offset > pool.size() || fp.text_size > pool.size() - fp.text_offset ||
+          fp.modifiers_offset > pool.size() || fp.modifiers_size > pool.size() - fp.modifiers_offset) {
+        return false;
+      }
+      auto &part = ret.emplace_back(fp.type, pool.substr(fp.text_offset, fp.text_size), pool.substr(fp.modifiers_offset, fp.modifiers_size));
+      part.unmerged_newline = fp.unmerged_newline;
+      if (!run(part.sub, fp.sub_count, depth + 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool done() const {
+    return (pos == count);
+  }
+
+private:
+  const flat_part_t *flat;
+  size_t count, pos = 0;
+  std::string_view pool;
+};
+
+} // namespace
+
+std::optional<std::vector<part_t>> load_cache(const char *cachefile, const char *sourcefile)
+{
+  header_t cur;
+  if (!stat_source(sourcefile, cur)) {
+    return {};
+  }
+
+  MappedFile file(cachefile);
+  if (!file.data || file.size < sizeof(header_t)) {
+    return {};
+  }
+
+  header_t hdr;
+  memcpy(&hdr, file.data, sizeof(hdr));
+  if (memcmp(hdr.magic, magic, sizeof(magic)) != 0 ||
+      hdr.version != format_version || hdr.endian != 0x01020304 ||
+      hdr.parser_version != parser_version ||
+      hdr.source_size != cur.source_size ||
+      hdr.source_mtime_sec != cur.source_mtime_sec ||
+      hdr.source_mtime_nsec != cur.source_mtime_nsec) {
+    return {};
+  }
+
+  const char *body = file.data + sizeof(header_t);
+  const size_t body_size = file.size - sizeof(header_t);
+  if ((uint64_t)hdr.part_count * sizeof(flat_part_t) + hdr.pool_size != body_size ||
+      hdr.root_count > hdr.part_count ||
+      checksum(hdr, body, body_size) != hdr.checksum) {
+    return {};
+  }
+
+  // (mmap'ed data is page aligned, and header_t keeps flat_part_t aligned)
+  Unflatten unflatten((const flat_part_t *)body, hdr.part_count,
+                      { body + hdr.part_count * sizeof(flat_part_t), hdr.pool_size });
+  std::vector<part_t> ret;
+  if (!unflatten.run(ret, hdr.root_count) || !unflatten.done()) {
+    return {};
+  }
+  return ret;
+}
+
+void write_cache(const std::vector<part_t> &parts, const char *cachefile, const char *sourcefile)
+{
+  header_t hdr = {};
+  memcpy(hdr.magic, magic, sizeof(magic));
+  hdr.version = format_version;
+  hdr.endian = 0x01020304;
+  hdr.parser_version = parser_version;
+  if (!stat_source(sourcefile, hdr)) {
+    throw std::system_error(errno, std::generic_category(), std::string("Failed to stat file: ").append(sourcefile));
+  }
+
+  std::vector<flat_part_t> flat;
+  std::string pool;
+  flatten(parts, flat, pool);
+  if (flat.size() > UINT32_MAX) {
+    throw std::length_error("template cache: too many parts");
+  }
+  hdr.part_count = flat.size();
+  hdr.root_count = parts.size();
+  hdr.pool_size = pool.size();
+  hdr.checksum = checksum(hdr, (const char *)flat.data(), flat.size() * sizeof(flat_part_t), pool);
+
+  write_file_atomic(cachefile, {
+    { (const char *)&hdr, sizeof(hdr) },
+    { (const char *)flat.data(), flat.size() * sizeof(flat_part_t) },
+    pool
+  });
+}
+
+} // namespace Template
+
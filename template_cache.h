@@ -0,0 +1,20 @@
+#pragma once
+
+#include "template_parser.h"
+#include <optional>
+
+namespace Template {
+
+// Binary cache of (parsed + optimized) parts:
+//   header (magic, format version, checksum, source file size + mtime), flat parts (pre-order, offsets into pool), string pool.
+// Loading only skips parsing + optimizing: the cache file is mmap'ed just while the parts are copied out of it,
+// i.e. each process still holds its own copy of the parts (no pages are shared between processes).
+
+// nullopt, when cachefile is missing, corrupt, from another format version, or stale w.r.t. sourcefile
+std::optional<std::vector<part_t>> load_cache(const char *cachefile, const char *sourcefile);
+
+// atomically replaces cachefile (write to temporary + rename); throws on error
+void write_cache(const std::vector<part_t> &parts, const char *cachefile, const char *sourcefile);
+
+} // namespace Template
+
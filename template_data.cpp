@@ -3,12 +3,45 @@
 namespace Template {
 namespace detail {
 
+const string_info_t string_info_t::single_line = {};
+
 map_init_t::map_init_t(const std::initializer_list<pair_init_t> &list)
-  : list(&list), map(list.size())
+  : list(&list), map(list.begin(), list.size())
+{
+}
+
+init_map_t::init_map_t(const pair_init_t *begin, size_t size)
+  : begin(begin), size(size)
+{
+  if (size >= index_min) {
+    build_index(); // (also checks duplicates)
+    return;
+  }
+  for (size_t i = 1; i < size; i++) {
+    for (size_t j = 0; j < i; j++) {
+      if (begin[i].key == begin[j].key) {
+        throw std::invalid_argument(std::string("duplicate key ").append(begin[i].key));
+      }
+    }
+  }
+}
+
+const value_init_t *init_map_t::find_linear(std::string_view key) const
 {
-  for (auto &it : list) {
-    if (!map.emplace(it.key, it.value).second) {
-      throw std::invalid_argument(std::string("duplicate key ").append(it.key));
+  for (const pair_init_t *it = begin, *end = begin + size; it != end; ++it) {
+    if (it->key == key) {
+      return &it->value;
+    }
+  }
+  return nullptr;
+}
+
+void init_map_t::build_index() const
+{
+  index = std::make_unique<std::unordered_map<std::string_view, const value_init_t *>>(size);
+  for (const pair_init_t *it = begin, *end = begin + size; it != end; ++it) {
+    if (!index->emplace(it->key, &it->value).second) {
+      throw std::invalid_argument(std::string("duplicate key ").append(it->key));
     }
   }
 }
@@ -27,6 +60,40 @@ Data::Data(const detail::map_init_t &&init)
       return data;
     } else if (init.ctdata) { // deep copy
       return init.ctdata->data;
+    } else if (init.table) { // copy row
+      const auto &keys = init.table->keys();
+      std::unordered_map<std::string, value_t> data(keys.size());
+      for (size_t i = 0; i < keys.size(); i++) {
+        data.emplace(keys[i], detail::value_init_t(init.table->get(init.row, i)));
+      }
+      return data;
+    } else if (init.snapshot) { // deep copy
+      std::unordered_map<std::string, value_t> data;
+      std::string_view key, string;
+      detail::number_t number;
+      uint32_t list;
+      for (size_t i = 0, n = detail::snapshot_map_slots(*init.snapshot, init.snapshot_offset); i < n; i++) {
+        if (!detail::snapshot_map_slot(*init.snapshot, init.snapshot_offset, i, key, string, number, list)) {
+          continue;
+        } else if (string.data()) {
+          data.emplace(key, detail::value_init_t(string));
+        } else if (number) {
+          data.emplace(key, detail::value_init_t(number));
+        } else {
+          data.emplace(key, detail::value_init_t(detail::list_init_t(*init.snapshot, list)));
+        }
+      }
+      return data;
+    } else if (init.adata) { // deep copy
+      std::unordered_map<std::string, value_t> data(init.adata->data.size());
+      for (auto &it : init.adata->data) {
+        if (!it.second.is_list()) {
+          data.emplace(it.first, detail::value_init_t(it.second.string));
+        } else {
+          data.emplace(it.first, detail::value_init_t(detail::list_init_t(it.second.list)));
+        }
+      }
+      return data;
     } else {
       throw std::invalid_argument("bad map_init_t");
     }
@@ -36,23 +103,160 @@ Data::Data(const detail::map_init_t &&init)
 
 Data::value_t::value_t(const detail::value_init_t &&init)
   : string(init.string), // "no-op" for init.is_list() (i.e. !init.string.data())
+    info(string),
+    number(init.number),
     list([&init]() -> List {
       if (!init.is_list()) {
         return {}; // "no-op"
+      } else if (init.list.windowed()) { // deep copy (of the window only)
+        List ret;
+        init.list.visit([&ret](const detail::map_init_t &map) {
+          ret.data.emplace_back(std::move(map));
+        });
+        return ret;
       } else if (init.list.list) {
         return std::move(*init.list.list);
       } else if (init.list.ctlist) { // deep copy
         return *init.list.ctlist;
+      } else if (init.list.table) { // (handled below)
+        return {};
+      } else if (init.list.snapshot) { // deep copy
+        List ret;
+        const size_t n = detail::snapshot_list_size(*init.list.snapshot, init.list.snapshot_offset);
+        ret.data.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+          ret.data.emplace_back(detail::map_init_t(*init.list.snapshot, detail::snapshot_list_item(*init.list.snapshot, init.list.snapshot_offset, i)));
+        }
+        return ret;
+      } else if (init.list.alist) { // deep copy
+        List ret;
+        ret.data.reserve(init.list.alist->data.size());
+        for (const auto *it : init.list.alist->data) {
+          ret.data.emplace_back(detail::map_init_t(*it));
+        }
+        return ret;
       } else {
         throw std::invalid_argument("bad value_init_t");
       }
-    }())
+    }()),
+    table((init.is_list() && init.list.table && !init.list.windowed()) ? std::make_shared<const Table>(*init.list.table) : nullptr)
 {
-  if (init.is_list() && !list.data.capacity()) {
+  if (init.is_list() && !table && !list.data.capacity()) {
     list.data.reserve(1); // trick/hack
     // assert(is_list());
   }
 }
 
+Data::value_t::value_t(std::shared_ptr<const Table> table)
+  : table(std::move(table))
+{
+  // assert(this->table);
+}
+
+void Data::set(std::string_view key, Table &&table)
+{
+  data.insert_or_assign(std::string(key), value_t(std::make_shared<const Table>(std::move(table))));
+}
+
+
+Table::Table(std::vector<std::string> keys)
+  : names(std::move(keys)), columns(names.size())
+{
+  schema.reserve(names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    if (!schema.emplace(names[i], i).second) {
+      throw std::invalid_argument(std::string("duplicate key ").append(names[i]));
+    }
+  }
+}
+
+void Table::reserve(size_t rows, size_t chars_per_value)
+{
+  for (auto &col : columns) {
+    col.ends.reserve(rows);
+    col.chars.reserve(rows * chars_per_value);
+  }
+}
+
+void Table::add_row(const std::string_view *values, size_t size)
+{
+  if (size != columns.size()) {
+    throw std::invalid_argument("Table row size does not match number of keys");
+  }
+  for (size_t i = 0; i < size; i++) {
+    if (!values[i].data()) {
+      throw std::invalid_argument("Table value may not be nullptr");
+    }
+    column_t &col = columns[i];
+    col.newlines += detail::string_info_t(values[i]).newlines;
+    col.chars.append(values[i]);
+    col.ends.push_back(col.chars.size());
+  }
+  rows++;
+}
+
+ArenaData &ArenaList::add()
+{
+  auto *resource = data.get_allocator().resource();
+  return *data.emplace_back(new (resource->allocate(sizeof(ArenaData), alignof(ArenaData))) ArenaData(resource));
+}
+
+std::string_view ArenaData::copy(std::string_view sv)
+{
+  char *ret = (char *)data.get_allocator().resource()->allocate(sv.size() ? sv.size() : 1, 1);
+  sv.copy(ret, sv.size());
+  return { ret, sv.size() };
+}
+
+void ArenaData::set(std::string_view key, std::string_view string)
+{
+  auto it = data.find(key);
+  if (it == data.end()) {
+    data.try_emplace(copy(key), copy(string), data.get_allocator().resource());
+  } else {
+    it->second.string = copy(string);
+    it->second.info = detail::string_info_t(string);
+    it->second.list.data.clear();
+  }
+}
+
+void ArenaData::set_borrowed(std::string_view key, std::string_view string)
+{
+  if (!string.data()) {
+    throw std::invalid_argument("ArenaData string may not be nullptr");
+  }
+  auto it = data.find(key);
+  if (it == data.end()) {
+    data.try_emplace(key, string, data.get_allocator().resource());
+  } else {
+    it->second.string = string;
+    it->second.info = detail::string_info_t(string);
+    it->second.list.data.clear();
+  }
+}
+
+ArenaList &ArenaData::list(std::string_view key)
+{
+  auto it = data.find(key);
+  if (it == data.end()) {
+    it = data.try_emplace(copy(key), std::string_view(), data.get_allocator().resource()).first;
+  } else if (!it->second.is_list()) {
+    throw std::invalid_argument(std::string("key '").append(key).append("' is not a List"));
+  }
+  return it->second.list;
+}
+
+
+DataArena::DataArena(size_t initial_size)
+  : initial(new char[initial_size]),
+    resource(initial.get(), initial_size)
+{
+}
+
+ArenaData &DataArena::create()
+{
+  return *new (resource.allocate(sizeof(ArenaData), alignof(ArenaData))) ArenaData(&resource);
+}
+
 } // namespace Template
 
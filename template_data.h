@@ -1,28 +1,46 @@
 #pragma once
 
+#include <algorithm>
 #include <unordered_map>
+#include <memory_resource>
+#include <memory>
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <string.h>
+#include <stdint.h>
 
 namespace Template {
 
 struct Data;
 struct List;
+struct ArenaData;
+struct ArenaList;
+struct Table;
+class Snapshot;
 
 namespace detail {
 
 struct map_init_t;
 struct value_init_t;
 struct pair_init_t;
+class init_map_t;
+class table_row_ctx_t;
+class snapshot_map_ctx_t;
 
 struct list_init_t {
 private:
   friend struct value_init_t;
   template <typename> friend class map_ctx_t;
+  friend class table_row_ctx_t;
+  friend class snapshot_map_ctx_t;
+  friend struct map_init_t;
 
   list_init_t() = default;
   list_init_t(list_init_t &&) = default;   // (+ deletes list_init_t(const list_init_t &) )
+
+  list_init_t(const Snapshot &snapshot, uint32_t offset)
+    : snapshot(&snapshot), snapshot_offset(offset) { }
 public:
 
   list_init_t(const std::initializer_list<map_init_t> &list)
@@ -31,13 +49,28 @@ public:
   list_init_t(const List &ctlist)
     : ctlist(&ctlist) { }
 
+  list_init_t(const ArenaList &alist)
+    : alist(&alist) { }
+
+  list_init_t(const Table &table)
+    : table(&table) { }
+
+  // window: only items [offset, offset + limit) are visited (a view, nothing is copied), cf. Template::window()
+  static constexpr const size_t all = (size_t)-1;
+  template <typename ListT>
+  list_init_t(const ListT &list, size_t offset, size_t limit)
+    : list_init_t(list) {
+    this->offset = offset;
+    this->limit = limit;
+  }
+
   // visitor(const map_init_t &)
   template <typename Visitor>
   void visit(Visitor&& visitor) const;
 
   // empty list_init_t is only visible via map_init_t::visit_mapctx...
   bool empty() const {
-    return (!list && !ctlist);
+    return (!list && !ctlist && !alist && !table && !snapshot);
   }
 
 private:
@@ -45,6 +78,123 @@ private:
 
   const std::initializer_list<map_init_t> *list = nullptr;
   const List *ctlist = nullptr;
+  const ArenaList *alist = nullptr;
+  const Table *table = nullptr;
+  const Snapshot *snapshot = nullptr;
+  uint32_t snapshot_offset = 0;
+
+  size_t offset = 0;
+  size_t limit = all;
+
+  bool windowed() const {
+    return (offset != 0 || limit != all);
+  }
+
+  // clamps window to [0, size)
+  void window_range(size_t size, size_t &begin, size_t &end) const {
+    begin = std::min(offset, size);
+    end = begin + std::min(limit, size - begin);
+  }
+};
+
+// cheap per-value metadata, precomputed when the value is stored (cf. Engine::render_context_t::out_indent)
+struct string_info_t {
+  string_info_t() = default;
+
+  explicit string_info_t(std::string_view sv) {
+    if (sv.empty()) {
+      return;  // (sv.data() might be nullptr, e.g. for lists: memchr(nullptr, ...) is UB)
+    }
+    const char *const begin = sv.data(), *const end = begin + sv.size();
+    for (const char *p = begin; (p = (const char *)memchr(p, '\n', end - p)); p++) {
+      if (!newlines++) {
+        first_newline = p - begin;
+      }
+      last_newline = p - begin;
+    }
+  }
+
+  size_t newlines = 0;          // 0: single line (then first_/last_newline are unused)
+  size_t first_newline = 0;
+  size_t last_newline = 0;      // i.e. last line starts at last_newline + 1
+
+  static const string_info_t single_line;
+};
+
+// numeric / boolean value, stored unformatted (formatted with std::to_chars only when rendered, cf. number_format_t)
+struct number_t {
+  enum struct type_e : char {
+    none, boolean, int64, uint64, float64
+  };
+
+  number_t() = default;
+
+  template <typename T>
+  static constexpr const bool is_number_v = std::is_arithmetic_v<T> &&
+    !std::is_same_v<T, char> && !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+  template <typename T, std::enable_if_t<is_number_v<T>, int> = 0>
+  number_t(T value) {
+    if constexpr (std::is_same_v<T, bool>) {
+      type = type_e::boolean;
+      b = value;
+    } else if constexpr (std::is_floating_point_v<T>) {
+      type = type_e::float64;
+      d = value;
+    } else if constexpr (std::is_signed_v<T>) {
+      type = type_e::int64;
+      i = value;
+    } else {
+      type = type_e::uint64;
+      u = value;
+    }
+  }
+
+  explicit operator bool() const {
+    return (type != type_e::none);
+  }
+
+  type_e type = type_e::none;
+  union {
+    bool b;
+    int64_t i;
+    uint64_t u;
+    double d = 0;
+  };
+};
+
+struct string_ref_t {
+  std::string_view string;               // not found: !.data() && !number
+  const string_info_t *info = nullptr;   // nullptr: not precomputed
+  number_t number;                       // (when set, string is not used)
+
+  bool found() const {
+    return (string.data() || number);
+  }
+};
+
+// lookup for initializer_list data, without allocation in the common case:
+// small lists are scanned linearly, a hash index is only built for large lists (or when queried often).
+// NOTE: the lazily built index is not thread-safe (initializer_lists are temporaries of a single render call)
+class init_map_t {
+public:
+  init_map_t() = default;
+  init_map_t(const pair_init_t *begin, size_t size);
+
+  // nullptr, when not found
+  inline const value_init_t *find(std::string_view key) const;
+
+private:
+  static constexpr const size_t linear_max = 8;    // never index
+  static constexpr const size_t index_min = 32;    // always index (i.e. already in ctor)
+
+  const value_init_t *find_linear(std::string_view key) const;
+  void build_index() const;
+
+  const pair_init_t *begin = nullptr;
+  size_t size = 0;
+  mutable size_t lookups = 0;
+  mutable std::unique_ptr<std::unordered_map<std::string_view, const value_init_t *>> index;
 };
 
 struct map_init_t {
@@ -53,16 +203,31 @@ struct map_init_t {
   map_init_t(const Data &ctdata)
     : ctdata(&ctdata) { }
 
+  map_init_t(const ArenaData &adata)
+    : adata(&adata) { }
+
+  map_init_t(const Table &table, size_t row)  // (row < table.size())
+    : table(&table), row(row) { }
+
+  map_init_t(const Snapshot &snapshot);  // root
+
+  map_init_t(const Snapshot &snapshot, uint32_t offset)
+    : snapshot(&snapshot), snapshot_offset(offset) { }
+
   map_init_t(const map_init_t &) = delete;
 
   // visitor(std::string_view key, std::string_view value)
+  // visitor(std::string_view key, const number_t &value)
   // visitor(std::string_view key, const list_init_t &value)
   template <typename Visitor>
   void visit(Visitor&& visitor) const;
 
   // needed for Engine::render_context_t
-  // visitor(const map_ctx_t<std::unordered_map<std::string_view, const detail::value_init_t &>> &map_ctx)
+  // visitor(const map_ctx_t<init_map_t> &map_ctx)
   // visitor(const map_ctx_t<std::unordered_map<std::string, Data::value_t>> &map_ctx)
+  // visitor(const map_ctx_t<std::pmr::unordered_map<std::string_view, ArenaData::value_t>> &map_ctx)
+  // visitor(const table_row_ctx_t &map_ctx)
+  // visitor(const snapshot_map_ctx_t &map_ctx)
   template <typename Visitor>
   void visit_mapctx(Visitor&& visitor) const;
 
@@ -71,8 +236,13 @@ private:
 
   const std::initializer_list<pair_init_t> *list = nullptr;
   const Data *ctdata = nullptr;
+  const ArenaData *adata = nullptr;
+  const Table *table = nullptr;
+  size_t row = 0;
+  const Snapshot *snapshot = nullptr;
+  uint32_t snapshot_offset = 0;
 
-  std::unordered_map<std::string_view, const value_init_t &> map; // only when (list != nullptr)
+  init_map_t map; // only when (list != nullptr)
 };
 
 struct value_init_t {
@@ -86,10 +256,13 @@ struct value_init_t {
   value_init_t(list_init_t &&list) // only allow temporaries / implicit conversion
     : list(std::move(list)) { }
 
+  value_init_t(const number_t &number)
+    : number(number) { }
+
   value_init_t(const value_init_t &) = delete;
 
   inline bool is_list() const {
-    return !string.data();
+    return (!string.data() && !number);
   }
 
 private:
@@ -99,6 +272,7 @@ private:
 
   std::string_view string;
   list_init_t list;
+  number_t number;
 };
 
 struct pair_init_t {
@@ -111,16 +285,28 @@ struct pair_init_t {
   pair_init_t(std::string_view key, const List &list)
     : key(key), value(list) { }
 
+  pair_init_t(std::string_view key, const Table &table)
+    : key(key), value(table) { }
+
+  pair_init_t(std::string_view key, list_init_t &&list) // e.g. Template::window()
+    : key(key), value(std::move(list)) { }
+
+  template <typename T, std::enable_if_t<number_t::is_number_v<T>, int> = 0>
+  pair_init_t(std::string_view key, T number)
+    : key(key), value(number) { }
+
 private:
   friend struct ::Template::Data;
   friend struct map_init_t;
+  friend class init_map_t;
 
   std::string_view key;
   value_init_t value;
 };
 
-// MapT = std::unordered_map<std::string_view, const value_init_t &>
+// MapT = init_map_t
 //     or std::unordered_map<std::string, Data::value_t>
+//     or std::pmr::unordered_map<std::string_view, ArenaData::value_t>
 template <typename MapT>
 class map_ctx_t {
   const MapT &map;
@@ -128,45 +314,78 @@ class map_ctx_t {
   explicit map_ctx_t(const MapT &map) : map(map) { }
   friend struct map_init_t;
 
-  static constexpr const bool is_init = std::is_same_v<decltype(map.begin()->second.list), list_init_t>;
+  static constexpr const bool is_init = std::is_same_v<MapT, init_map_t>;
+
+  // nullptr, when not found
+  auto find(const std::string &name) const {
+    if constexpr (is_init) {
+      return map.find(name);
+    } else {
+      auto it = map.find(name);
+      return (it != map.end()) ? &it->second : nullptr;
+    }
+  }
 public:
 
   bool has(const std::string &name) const {
-    return (map.find(name) != map.end());
+    return find(name);
   }
 
-  // not found: !.data()
-  std::string_view get_string(const std::string &name) const {
-    auto it = map.find(name);
-    if (it == map.end()) {
-      return {}; // -> (!.data())
-    } else if (it->second.is_list()) {
+  // not found: !.found()
+  string_ref_t get_string(const std::string &name) const {
+    const auto *value = find(name);
+    if (!value) {
+      return {}; // -> (!.found())
+    } else if (value->is_list()) {
       throw std::runtime_error(std::string("Expected String, got List for variable '").append(name).append("'"));
+    } else if (value->number) {
+      return { {}, nullptr, value->number };
+    }
+    // assert(value->string.data()); // via value_init_t ctor / value_t std::string
+    if constexpr (is_init) {
+      return { value->string };
+    } else {
+      return { value->string, &value->info };
     }
-    // assert(it->second.string.data()); // via value_init_t ctor / value_t std::string
-    return it->second.string;
   }
 
   // not found: .empty()
   auto get_list(const std::string &name) const
     -> std::conditional_t<is_init, const list_init_t &, list_init_t> {
-    auto it = map.find(name);
-    if (it == map.end()) {
+    const auto *value = find(name);
+    if (!value) {
       if constexpr (is_init) {
         static constexpr const list_init_t none;
         return none; // -> (.empty())
       } else {
         return {}; // -> (.empty())
       }
-    } else if (!it->second.is_list()) {
+    } else if (!value->is_list()) {
       throw std::runtime_error(std::string("Expected List, got String for group '").append(name).append("'"));
     }
-    // it->second.list = const list_init_t &  (contains either initializer_list<map_init_t>, or List)
-    //                or const List &         (only contains Data/List)
-    return it->second.list;
+    // value->list = const list_init_t &  (contains either initializer_list<map_init_t>, List, ArenaList or Table)
+    //            or List / Table         (only contains Data/List), via as_list()
+    //            or ArenaList            (only contains ArenaData/ArenaList), via as_list()
+    if constexpr (is_init) {
+      return value->list;
+    } else {
+      return value->as_list();
+    }
   }
 };
 
+inline const value_init_t *init_map_t::find(std::string_view key) const
+{
+  if (index) {
+    auto it = index->find(key);
+    return (it != index->end()) ? it->second : nullptr;
+  } else if (size > linear_max && ++lookups > size) { // queried often: amortized
+    build_index();
+    return find(key);
+  }
+  return find_linear(key);
+}
+
 } // namespace detail
 
 struct List {
@@ -217,6 +436,14 @@ struct Data {
   void set(std::string_view key, const List &list) {
     data.insert_or_assign(std::string(key), detail::value_init_t(list));
   }
+  void set(std::string_view key, const Table &table) { // (copied, but stays columnar)
+    data.insert_or_assign(std::string(key), detail::value_init_t(table));
+  }
+  void set(std::string_view key, Table &&table);
+  template <typename T, std::enable_if_t<detail::number_t::is_number_v<T>, int> = 0>
+  void set(std::string_view key, T number) { // (stored unformatted)
+    data.insert_or_assign(std::string(key), detail::value_init_t(number));
+  }
 
   void add_list(std::string_view key, Data &&map) {
     get_list(key).add(std::move(map));
@@ -230,7 +457,7 @@ private:
 
   List &get_list(std::string_view key) { // created, when missing
     auto [it, inserted] = data.emplace(key, detail::list_init_t({}));
-    if (!inserted && !it->second.is_list()) {
+    if (!inserted && (!it->second.is_list() || it->second.table)) {
       throw std::invalid_argument(std::string("key '").append(key).append("' is not a List"));
     }
     return it->second.list;
@@ -238,29 +465,261 @@ private:
 
   struct value_t {
     value_t(const detail::value_init_t &&init);
+    value_t(std::shared_ptr<const Table> table);
 
     inline bool is_list() const {
-      return (list.data.capacity() > 0);
+      return (list.data.capacity() > 0 || table);
+    }
+
+    detail::list_init_t as_list() const {
+      if (table) {
+        return *table;
+      }
+      return list;
     }
 
     // NOTE: naming must match with value_init_t for map_ctx_t<...>
     std::string string;
+    detail::string_info_t info;
+    detail::number_t number;
     List list;
+    std::shared_ptr<const Table> table;  // (immutable, thus can be shared by copies)
   };
 
   std::unordered_map<std::string, value_t> data;
 };
 
+// Arena-backed alternative to Data/List, for short-lived (e.g. per-request) contexts:
+// all nodes and copied strings are bump-allocated from a DataArena and freed at once by DataArena::reset().
+// NOTE: nodes are never destroyed individually, and must not be used after reset().
+struct ArenaList {
+  ArenaData &add(); // appends new, empty item
+
+  bool empty() const {
+    return data.empty();
+  }
+
+private:
+  friend struct ArenaData;
+  friend struct Data; // (actually Data::value_t)
+  template <typename Visitor> friend void detail::list_init_t::visit(Visitor&&) const;
+
+  explicit ArenaList(std::pmr::memory_resource *resource)
+    : data(resource) { }
+
+  std::pmr::vector<ArenaData *> data;
+};
+
+struct ArenaData {
+  ArenaData(const ArenaData &) = delete;
+  ArenaData &operator=(const ArenaData &) = delete;
+
+  // copies key and string into the arena
+  void set(std::string_view key, std::string_view string);
+  // does not copy: caller guarantees that key and string outlive any use of this ArenaData
+  void set_borrowed(std::string_view key, std::string_view string);
+
+  ArenaList &list(std::string_view key); // created (empty), when missing
+  ArenaData &add_list(std::string_view key) { // add new item to list at key
+    return list(key).add();
+  }
+
+private:
+  friend class DataArena;
+  friend struct ArenaList;
+  friend struct Data;
+  friend struct detail::map_init_t;  // visit, visit_mapctx
+
+  explicit ArenaData(std::pmr::memory_resource *resource)
+    : data(resource) { }
+
+  std::string_view copy(std::string_view sv);
+
+  struct value_t {
+    value_t(std::string_view string, std::pmr::memory_resource *resource)
+      : string(string), info(string), list(resource) { }
+
+    inline bool is_list() const {
+      return !string.data();
+    }
+
+    detail::list_init_t as_list() const {
+      return list;
+    }
+
+    // NOTE: naming must match with value_init_t for map_ctx_t<...>
+    std::string_view string;
+    detail::string_info_t info;
+    detail::number_t number;   // (always none)
+    ArenaList list;
+  };
+
+  std::pmr::unordered_map<std::string_view, value_t> data;
+};
+
+class DataArena {
+public:
+  // initial_size is kept allocated across reset()
+  explicit DataArena(size_t initial_size = 64 * 1024);
+  DataArena(const DataArena &) = delete;
+  DataArena &operator=(const DataArena &) = delete;
+
+  ArenaData &create(); // new, empty root
+
+  // frees all ArenaData / ArenaList / strings created from this arena
+  void reset() {
+    resource.release();
+  }
+
+private:
+  std::unique_ptr<char[]> initial;
+  std::pmr::monotonic_buffer_resource resource;
+};
+
+// Columnar alternative to List, for large groups of homogeneous rows (string values only):
+// one shared key schema, each column is stored as contiguous characters + end offsets.
+struct Table {
+  explicit Table(std::vector<std::string> keys);
+
+  // values in schema order
+  void add_row(const std::initializer_list<std::string_view> &values) {
+    add_row(values.begin(), values.size());
+  }
+  void add_row(const std::vector<std::string_view> &values) {
+    add_row(values.data(), values.size());
+  }
+
+  void reserve(size_t rows, size_t chars_per_value = 0);
+
+  size_t size() const {
+    return rows;
+  }
+
+  const std::vector<std::string> &keys() const {
+    return names;
+  }
+
+  // npos, when not found
+  size_t column(const std::string &key) const {
+    auto it = schema.find(key);
+    return (it != schema.end()) ? it->second : std::string_view::npos;
+  }
+
+  std::string_view get(size_t row, size_t column) const {
+    const column_t &col = columns[column];
+    const size_t start = (row > 0) ? col.ends[row - 1] : 0;
+    return { col.chars.data() + start, col.ends[row] - start };
+  }
+
+  // whether no value in column contains a newline
+  bool single_line(size_t column) const {
+    return !columns[column].newlines;
+  }
+
+private:
+  void add_row(const std::string_view *values, size_t size);
+
+  struct column_t {
+    std::string chars;
+    std::vector<size_t> ends;
+    size_t newlines = 0;
+  };
+
+  std::vector<std::string> names;
+  std::unordered_map<std::string, size_t> schema;   // name -> column
+  std::vector<column_t> columns;
+  size_t rows = 0;
+};
+
+namespace detail {
+// MapCtxT for a single Table row (cf. map_ctx_t)
+class table_row_ctx_t {
+  const Table &table;
+  const size_t row;
+
+  table_row_ctx_t(const Table &table, size_t row) : table(table), row(row) { }
+  friend struct map_init_t;
+public:
+
+  bool has(const std::string &name) const {
+    return (table.column(name) != std::string_view::npos);
+  }
+
+  // not found: !.found()
+  string_ref_t get_string(const std::string &name) const {
+    const size_t col = table.column(name);
+    if (col == std::string_view::npos) {
+      return {}; // -> (!.found())
+    }
+    return { table.get(row, col), table.single_line(col) ? &string_info_t::single_line : nullptr };
+  }
+
+  // not found: .empty()
+  list_init_t get_list(const std::string &name) const {
+    if (has(name)) {
+      throw std::runtime_error(std::string("Expected List, got String for group '").append(name).append("'"));
+    }
+    return {}; // -> (.empty())
+  }
+};
+
+// Snapshot access (implemented in template_snapshot.cpp)
+
+// MapCtxT for a map stored in a Snapshot (cf. map_ctx_t)
+class snapshot_map_ctx_t {
+  const Snapshot &snapshot;
+  const uint32_t offset;
+
+  snapshot_map_ctx_t(const Snapshot &snapshot, uint32_t offset) : snapshot(snapshot), offset(offset) { }
+  friend struct map_init_t;
+public:
+
+  bool has(const std::string &name) const;
+
+  // not found: !.found()
+  string_ref_t get_string(const std::string &name) const;
+
+  // not found: .empty()
+  list_init_t get_list(const std::string &name) const;
+};
+
+size_t snapshot_list_size(const Snapshot &snapshot, uint32_t list);
+uint32_t snapshot_list_item(const Snapshot &snapshot, uint32_t list, size_t index); // -> map
+
+size_t snapshot_map_slots(const Snapshot &snapshot, uint32_t map);
+// false, when slot is empty; otherwise either string (.data() != nullptr), number or list is set
+bool snapshot_map_slot(const Snapshot &snapshot, uint32_t map, size_t slot, std::string_view &key, std::string_view &string, number_t &number, uint32_t &list);
+
+} // namespace detail
+
 template <typename Visitor>
 void detail::list_init_t::visit(Visitor&& visitor) const
 {
+  size_t begin, end; // (i.e. O(window size), not O(list size))
   if (list) {
-    for (const auto &it : *list) {
-      visitor(it);
+    window_range(list->size(), begin, end);
+    for (auto it = list->begin() + begin, last = list->begin() + end; it != last; ++it) {
+      visitor(*it);
     }
   } else if (ctlist) {
-    for (const auto &it : ctlist->data) {
-      visitor(map_init_t(it));
+    window_range(ctlist->data.size(), begin, end);
+    for (size_t i = begin; i < end; i++) {
+      visitor(map_init_t(ctlist->data[i]));
+    }
+  } else if (alist) {
+    window_range(alist->data.size(), begin, end);
+    for (size_t i = begin; i < end; i++) {
+      visitor(map_init_t(*alist->data[i]));
+    }
+  } else if (table) {
+    window_range(table->size(), begin, end);
+    for (size_t i = begin; i < end; i++) {
+      visitor(map_init_t(*table, i));
+    }
+  } else if (snapshot) {
+    window_range(snapshot_list_size(*snapshot, snapshot_offset), begin, end);
+    for (size_t i = begin; i < end; i++) {
+      visitor(map_init_t(*snapshot, snapshot_list_item(*snapshot, snapshot_offset, i)));
     }
   } // else: empty -> no-op
 }
@@ -270,7 +729,9 @@ void detail::map_init_t::visit(Visitor&& visitor) const
 {
   if (list) {
     for (auto &it : *list) {
-      if (!it.value.is_list()) {
+      if (it.value.number) {
+        visitor(it.key, it.value.number);
+      } else if (!it.value.is_list()) {
         visitor(it.key, it.value.string);
       } else {
         visitor(it.key, it.value.list);
@@ -278,12 +739,42 @@ void detail::map_init_t::visit(Visitor&& visitor) const
     }
   } else if (ctdata) {
     for (auto &it : ctdata->data) {
+      if (it.second.number) {
+        visitor(it.first, it.second.number);
+      } else if (!it.second.is_list()) {
+        visitor(it.first, it.second.string);
+      } else {
+        visitor(it.first, it.second.as_list());
+      }
+    }
+  } else if (adata) {
+    for (auto &it : adata->data) {
       if (!it.second.is_list()) {
         visitor(it.first, it.second.string);
       } else {
         visitor(it.first, list_init_t(it.second.list));
       }
     }
+  } else if (table) {
+    const auto &keys = table->keys();
+    for (size_t i = 0; i < keys.size(); i++) {
+      visitor(std::string_view(keys[i]), table->get(row, i));
+    }
+  } else if (snapshot) {
+    std::string_view key, string;
+    number_t number;
+    uint32_t list;
+    for (size_t i = 0, n = snapshot_map_slots(*snapshot, snapshot_offset); i < n; i++) {
+      if (!snapshot_map_slot(*snapshot, snapshot_offset, i, key, string, number, list)) {
+        continue;
+      } else if (string.data()) {
+        visitor(key, string);
+      } else if (number) {
+        visitor(key, number);
+      } else {
+        visitor(key, list_init_t(*snapshot, list));
+      }
+    }
   } // else: assert(0);  // (no ctor that would allow this)
 }
 
@@ -294,8 +785,22 @@ void detail::map_init_t::visit_mapctx(Visitor&& visitor) const
     visitor(map_ctx_t(map));
   } else if (ctdata) {
     visitor(map_ctx_t(ctdata->data));
+  } else if (adata) {
+    visitor(map_ctx_t(adata->data));
+  } else if (table) {
+    visitor(table_row_ctx_t(*table, row));
+  } else if (snapshot) {
+    visitor(snapshot_map_ctx_t(*snapshot, snapshot_offset));
   } // else: assert(0);
 }
 
+// renders only items [offset, offset + limit) of list (List, ArenaList, Table, initializer_list), without copying;
+// joiner and newline handling are the same as for a full list, e.g. tmpl.render({ {"rows", Template::window(rows, 20, 10)} });
+template <typename ListT>
+detail::list_init_t window(const ListT &list, size_t offset, size_t limit = detail::list_init_t::all)
+{
+  return detail::list_init_t(list, offset, limit);
+}
+
 } // namespace Template
 
@@ -1,37 +1,224 @@
 #include "template_engine.h"
 #include "template_parser.h"
+#include "template_cache.h"
+#include "template_hash.h"
 #include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <set>
+#include <string.h>
 
 namespace Template {
 Engine::Engine(std::vector<part_t> parts)
- : parts(std::move(parts))
+ : parts(std::move(parts)), identity(hash_parts(this->parts))
 {
+  stats.parts_before = stats.parts_after = count_parts(this->parts);
 }
 
+Engine::Engine(Engine &&) = default;
+Engine &Engine::operator=(Engine &&) = default;
 Engine::~Engine() = default;
 
 Engine Engine::fromString(const std::string_view &sv)
 {
-  return parse_string(sv);
+  Engine ret(parse_string(sv));
+  ret.optimize();
+  return ret;
 }
 
 Engine Engine::fromFile(const char *filename)
 {
-  return parse_file(filename);
+  Engine ret(parse_file(filename));
+  ret.optimize();
+  return ret;
 }
 
+Engine Engine::fromCachedFile(const char *filename, const char *cachefile)
+{
+  if (auto parts = load_cache(cachefile, filename)) {
+    return Engine(std::move(*parts));  // (already optimized)
+  }
+
+  Engine ret = fromFile(filename);
+  try {
+    write_cache(ret.parts, cachefile, filename);
+  } catch (std::exception &) {
+    // the cache is only an optimization
+  }
+  return ret;
+}
+
+Engine::optimize_stats_t Engine::optimize()
+{
+  const size_t before = count_parts(parts);
+  optimize_parts(parts);
+  identity = hash_parts(parts);
+  stats.parts_after = count_parts(parts);
+  return { before, stats.parts_after };
+}
+
+namespace {
+// (buffer must be large enough for any double in fixed notation with precision <= 99)
+char *format_number(char *buf, char *end, const detail::number_t &number, const number_format_t &format)
+{
+  using style_e = number_format_t::style_e;
+  std::to_chars_result res = { buf, std::errc() };  // (i.e. empty, for any unhandled style)
+  switch (number.type) {
+  case detail::number_t::type_e::none:
+  default:
+    return buf;
+
+  case detail::number_t::type_e::boolean: {
+      const std::string_view str = number.b ? "true" : "false";
+      return buf + str.copy(buf, str.size());
+    }
+
+  case detail::number_t::type_e::int64:
+  case detail::number_t::type_e::uint64:
+    if (format.style == style_e::scientific || format.style == style_e::general) {
+      const double d = (number.type == detail::number_t::type_e::int64) ? (double)number.i : (double)number.u;
+      return format_number(buf, end, d, format);
+    }
+    res = (number.type == detail::number_t::type_e::int64)
+      ? std::to_chars(buf, end, number.i, (format.style == style_e::hex) ? 16 : 10)
+      : std::to_chars(buf, end, number.u, (format.style == style_e::hex) ? 16 : 10);
+    if (res.ec == std::errc() && format.style == style_e::fixed && format.precision > 0 &&
+        end - res.ptr > format.precision) {
+      *res.ptr++ = '.';
+      res.ptr = std::fill_n(res.ptr, format.precision, '0');
+    }
+    break;
+
+  case detail::number_t::type_e::float64:
+    switch (format.style) {
+    case style_e::shortest:
+      res = std::to_chars(buf, end, number.d);
+      break;
+    case style_e::fixed:
+      res = (format.precision < 0) ? std::to_chars(buf, end, number.d, std::chars_format::fixed)
+                                   : std::to_chars(buf, end, number.d, std::chars_format::fixed, format.precision);
+      break;
+    case style_e::scientific:
+      res = (format.precision < 0) ? std::to_chars(buf, end, number.d, std::chars_format::scientific)
+                                   : std::to_chars(buf, end, number.d, std::chars_format::scientific, format.precision);
+      break;
+    case style_e::general:
+      res = (format.precision < 0) ? std::to_chars(buf, end, number.d, std::chars_format::general)
+                                   : std::to_chars(buf, end, number.d, std::chars_format::general, format.precision);
+      break;
+    case style_e::hex:
+      res = std::to_chars(buf, end, number.d, std::chars_format::hex);
+      break;
+    }
+    break;
+  }
+  if (res.ec != std::errc()) {
+    throw std::logic_error("format_number: buffer too small");
+  }
+  return res.ptr;
+}
+} // namespace
+
 struct Engine::render_context_t {
+  // appends to out; hash (optional): fed with the appended bytes
+  void render_to(std::string &out, const std::vector<part_t> &parts, const detail::map_init_t &map, Hash64 *hash = nullptr) {
+    start(out, hash, nullptr);
+    render(parts, map);
+    flush_hash();
+    out_hash = nullptr;
+    buf = nullptr;
+  }
+
+  // replaces iov / side: segments point to template text, value strings, and into side (generated content)
+  void render_segments(std::vector<iovec> &iov, std::string &side, const std::vector<part_t> &parts, const detail::map_init_t &map) {
+    iov.clear();
+    side.clear();
+    side_segs.clear();
+    start(side, nullptr, nullptr);
+    this->iov = &iov;
+    render(parts, map);
+
+    // (side may have been reallocated while rendering: offsets -> pointers)
+    for (const size_t idx : side_segs) {
+      iov[idx].iov_base = side.data() + (uintptr_t)iov[idx].iov_base;
+    }
+    this->iov = nullptr;
+    buf = nullptr;
+  }
+
+  // feeds the values that rendering would read into hash, without producing output
+  void hash_inputs(const std::vector<part_t> &parts, const detail::map_init_t &map, Hash64 &hash) {
+    dry_buf.clear();
+    start(dry_buf, nullptr, &hash);  // (dry_buf: only for the rollback bookkeeping of optionals; stays empty)
+    render(parts, map);
+    input_hash = nullptr;
+    buf = nullptr;
+  }
+
+private:
+  // sets all mode state: a previous render (with the same session) might have thrown, leaving stale pointers
+  void start(std::string &out, Hash64 *out_hash, Hash64 *input_hash) {
+    buf = &out;
+    indent.clear();
+    optional_depth = 0;
+    this->out_hash = out_hash;
+    hashed = out.size();
+    this->input_hash = input_hash;
+    iov = nullptr;
+    held_warnings.clear();
+  }
+
   void render(const std::vector<part_t> &parts, const detail::map_init_t &map) {
     map.visit_mapctx([this, &parts](const auto &map_ctx) {
       for (const auto &part : parts) {
         render_one(part, map_ctx);
+        if (optional_depth == 0) {
+          flush_hash();  // (while the output is still in cache)
+        }
       }
     });
   }
 
-private:
+  // output inside a (speculative) optional can still be rolled back, i.e. must only be hashed at depth 0
+  void flush_hash() {
+    if (out_hash) {
+      out_hash->update(buf->data() + hashed, buf->size() - hashed);
+      hashed = buf->size();
+    }
+  }
+
+  // (name, type tag, value): keeps "a"+"bc" and "ab"+"c" apart
+  void hash_input(const std::string &name, const detail::string_ref_t &ref) {
+    const uint64_t size = name.size();
+    input_hash->update(&size, sizeof(size));
+    input_hash->update(name);
+
+    if (ref.number) {
+      const char type = 'n' + (char)ref.number.type;
+      const uint64_t bits = (ref.number.type == detail::number_t::type_e::boolean) ? ref.number.b : ref.number.u;
+      input_hash->update(&type, 1);
+      input_hash->update(&bits, sizeof(bits));
+    } else if (ref.string.data()) {
+      const uint64_t len = ref.string.size();
+      input_hash->update("s", 1);
+      input_hash->update(&len, sizeof(len));
+      input_hash->update(ref.string);
+    } else {
+      input_hash->update("-", 1);
+    }
+  }
+
+  void hash_input_tag(const std::string &name, char tag) {
+    const uint64_t size = name.size();
+    input_hash->update(&size, sizeof(size));
+    input_hash->update(name);
+    input_hash->update(&tag, 1);
+  }
+
+  // returns false, when a variable / group (directly) referenced by part is missing;
+  // in_optional: no warning is printed in that case (caller rolls back)
   template <typename MapCtxT>
-  void render_one(const part_t &part, const MapCtxT &map_ctx);
+  bool render_one(const part_t &part, const MapCtxT &map_ctx, bool in_optional = false);
 
   void add_indent(std::string_view sv, char unmerged_newline = 0) {
     if (unmerged_newline) {
@@ -39,13 +226,17 @@ private:
       return;
     }
 
-    // convert text to "space", but keep tabs...
     const size_t pos = sv.rfind('\n');
     if (pos != sv.npos) {
       sv.remove_prefix(pos + 1);
       indent.clear();
     }
+    add_indent_line(sv);
+  }
 
+  // sv must not contain '\n'
+  void add_indent_line(std::string_view sv) {
+    // convert text to "space", but keep tabs...
     const size_t dpos = indent.size();
     indent.resize(dpos + sv.size(), ' ');
     for (size_t i = 0; i < sv.size(); i++) {
@@ -57,67 +248,201 @@ private:
 
   // does add_indent internally!
   void out_indent(const std::string_view &sv) {
-    size_t pos = sv.find('\n'), next;
-    if (pos == sv.npos) {
+    out_indent(sv, detail::string_info_t(sv));
+  }
+
+  // info: precomputed (e.g. by Data), or just computed
+  void out_indent(const std::string_view &sv, const detail::string_info_t &info) {
+    if (input_hash) {
+      return;
+    } else if (!info.newlines) {
       out(sv);
-      add_indent(sv);
-    } else {
-      // "explode()", but keep delimiter at the ends
+      add_indent_line(sv);
+      return;
+    }
+
+    // "explode()", but keep delimiter at the ends; memchr is vectorized, and the exact size is reserved up front
+    const char *start = sv.data(), *const end = start + sv.size();
+    const char *const last = start + info.last_newline;
+    if (!iov) {
+      buf->reserve(buf->size() + sv.size() + info.newlines * indent.size());
+    }
 #if 1  // indent all lines
-      out(sv.substr(0, pos + 1));
-      out(indent);
-      while ((next = sv.find('\n', pos + 1)) != sv.npos) {
-        out(sv.substr(pos + 1, next - pos));
-        out(indent);
-        pos = next;
-      }
-      out(sv.substr(pos + 1));
-      add_indent(sv.substr(pos + 1));
-#else  // only indent non-empty lines
-      out(sv.substr(0, pos + 1));
-      while ((next = sv.find('\n', pos + 1)) != sv.npos) {
-        if (pos + 1 < next) { // no indent for empty lines
-          out(indent);
-          out(sv.substr(pos + 1, next - pos));
-        }
-        pos = next;
+    for (const char *nl = start + info.first_newline; ; nl = find_newline(start, last + 1)) {
+      out_piece(start, nl + 1);
+      out_generated(indent);
+      start = nl + 1;
+      if (nl == last) {
+        break;
       }
-      if (pos + 1 < sv.size()) { // no indent for empty last line  // TODO? only when variable part is directly followed by newline ?
-        out(indent);
-        out(sv.substr(pos + 1));
-        add_indent(sv.substr(pos + 1));
-      } else {
-        indent.clear();
+    }
+    out_piece(start, end);
+    add_indent_line({ start, (size_t)(end - start) });
+#else  // only indent non-empty lines
+    out_piece(start, start + info.first_newline + 1);
+    start += info.first_newline + 1;
+    while (start <= last) {
+      const char *nl = find_newline(start, last + 1);
+      if (start < nl) { // no indent for empty lines
+        out_generated(indent);
+        out_piece(start, nl + 1);
       }
+      start = nl + 1;
+    }
+    if (start < end) { // no indent for empty last line  // TODO? only when variable part is directly followed by newline ?
+      out_generated(indent);
+      out_piece(start, end);
+      add_indent_line({ start, (size_t)(end - start) });
+    } else {
+      indent.clear();
+    }
 #endif
+  }
+
+  // does add_indent internally!
+  void out_number(const detail::number_t &number, const number_format_t &format) {
+    if (input_hash) {
+      return;
     }
+    char tmp[512];
+    const std::string_view sv(tmp, format_number(tmp, tmp + sizeof(tmp), number, format) - tmp);
+    out_generated(sv);
+    add_indent_line(sv);
+  }
+
+  static const char *find_newline(const char *start, const char *end) {
+    return (const char *)memchr(start, '\n', end - start);
   }
 
   void out_newline(char unmerged_newline) {
     if (unmerged_newline) {
-      out({ &unmerged_newline, 1 });
+      out_generated({ &unmerged_newline, 1 });
     }
   }
 
+  // sv: template text or value string, i.e. stays valid after rendering
   void out(const std::string_view &sv) {
-    printf("%.*s", (int)sv.size(), sv.data());  // FIXME...
+    if (input_hash) {
+      return;
+    } else if (iov) {
+      out_ref(sv);
+    } else {
+      buf->append(sv);
+    }
+  }
+
+  void out_piece(const char *start, const char *end) {
+    if (iov) {
+      out_ref({ start, (size_t)(end - start) });
+    } else {
+      buf->append(start, end);
+    }
+  }
+
+  // sv: temporary (indent, formatted number, ...)
+  void out_generated(const std::string_view &sv) {
+    if (input_hash || sv.empty()) {
+      return;
+    }
+    if (iov) {
+      if (!side_segs.empty() && side_segs.back() == iov->size() - 1 &&
+          (uintptr_t)iov->back().iov_base + iov->back().iov_len == buf->size()) {
+        iov->back().iov_len += sv.size();
+      } else {
+        side_segs.push_back(iov->size());
+        iov->push_back({ (void *)(uintptr_t)buf->size(), sv.size() });  // (offset into buf, resolved at the end)
+      }
+    }
+    buf->append(sv);
+  }
+
+  void out_ref(const std::string_view &sv) {
+    if (sv.empty()) {
+      return;
+    } else if (!iov->empty() && (side_segs.empty() || side_segs.back() != iov->size() - 1) &&
+               (const char *)iov->back().iov_base + iov->back().iov_len == sv.data()) {
+      iov->back().iov_len += sv.size();  // contiguous
+    } else {
+      iov->push_back({ (void *)sv.data(), sv.size() });
+    }
+  }
+
+  // for rollback of (speculative) optionals
+  struct mark_t {
+    size_t warnings, buf, segs, side_segs, last_len;
+  };
+
+  mark_t mark() const {
+    if (!iov) {
+      return { held_warnings.size(), buf->size() };
+    }
+    return { held_warnings.size(), buf->size(), iov->size(), side_segs.size(), (iov->empty()) ? 0 : iov->back().iov_len };
+  }
+
+  void rollback(const mark_t &mark) {
+    held_warnings.resize(mark.warnings);
+    buf->resize(mark.buf);
+    if (iov) {
+      iov->resize(mark.segs);
+      side_segs.resize(mark.side_segs);
+      if (mark.segs) {
+        iov->back().iov_len = mark.last_len;  // (might have been extended)
+      }
+    }
+  }
+
+  void warn(const char *prefix, const std::string &name, const char *suffix) { // (no allocation)
+    if (input_hash) {
+      return;  // (the actual render will warn)
+    } else if (optional_depth) { // held back until the optional is committed
+      held_warnings.append("Warning: ").append(prefix).append(name).append(suffix).push_back('\n');
+      return;
+    }
+    fprintf(stderr, "Warning: %s%s%s\n", prefix, name.c_str(), suffix);
   }
 
-  void warn(const std::string_view &sv) {
-    fprintf(stderr, "Warning: %.*s\n", (int)sv.size(), sv.data());
+  void flush_warnings() {
+    if (!held_warnings.empty()) {
+      fputs(held_warnings.c_str(), stderr);
+      held_warnings.clear();
+    }
+  }
+
+  // i.e. whether the optional is rendered (at all)
+  template <typename MapCtxT>
+  static bool has_all(const std::vector<part_t> &sub, const MapCtxT &map_ctx) {
+    return std::all_of(sub.begin(), sub.end(), [&map_ctx](const auto &p) {
+      return (p.type == part_type_e::text || p.type == part_type_e::optional || map_ctx.has(p.text_name));
+    });
   }
 
   // Output ...
+  std::string *buf = nullptr;
   std::string indent = {};
+
+  // indent to restore on rollback, per optional nesting level (kept, to reuse capacity)
+  std::vector<std::string> saved_indents = {};
+  size_t optional_depth = 0;
+  std::string held_warnings = {};      // of not yet committed optionals
+
+  // Segment output (buf: side buffer) ...
+  std::vector<iovec> *iov = nullptr;
+  std::vector<size_t> side_segs = {};  // indices into iov, whose iov_base still is an offset into buf
+
+  // Hashing ...
+  Hash64 *out_hash = nullptr;
+  size_t hashed = 0;                   // buf position up to which out_hash was fed
+  Hash64 *input_hash = nullptr;        // set: dry run, no output
+  std::string dry_buf = {};
 };
 
 // MapCtxT<...> {
 //   bool has(const std::string &name) const;
-//   std::string_view get_string(const std::string &name) const;
+//   string_ref_t get_string(const std::string &name) const;
 //   {const list_init_t &, list_init_t} get_list(const std::string &name) const;
 // }
 template <typename MapCtxT>
-void Engine::render_context_t::render_one(const part_t &part, const MapCtxT &map_ctx)
+bool Engine::render_context_t::render_one(const part_t &part, const MapCtxT &map_ctx, bool in_optional)
 {
   switch (part.type) {
   case part_type_e::text:
@@ -126,21 +451,67 @@ void Engine::render_context_t::render_one(const part_t &part, const MapCtxT &map
     break;
 
   case part_type_e::variable: {
-      auto sv = map_ctx.get_string(part.text_name);
-      if (sv.data()) {
+      const auto ref = map_ctx.get_string(part.text_name);
+      if (input_hash) {
+        hash_input(part.text_name, ref);
+      }
+      if (ref.number) {
+        out_number(ref.number, part.number_format);  // calls add_indent internally
+      } else if (ref.string.data()) {
 // FIXME: part.modifiers_joiner -> formatter
-        out_indent(sv);  // calls add_indent internally
+        if (ref.info) {
+          out_indent(ref.string, *ref.info);  // calls add_indent internally
+        } else {
+          out_indent(ref.string);
+        }
+      } else if (in_optional) {
+        return false;
       } else {
-        warn(std::string("Variable '").append(part.text_name).append("' not found"));
+        warn("Variable '", part.text_name, "' not found");
       }
     }
     break;
 
   case part_type_e::optional: {
+#if 1  // speculative: render directly (each variable is looked up once), roll back when a variable / group is missing
+      const mark_t mark = this->mark();
+      if (saved_indents.size() <= optional_depth) {
+        saved_indents.resize(optional_depth + 1);
+      }
+      saved_indents[optional_depth].assign(indent);
+
+      optional_depth++;
+      bool full;
+      try {
+        full = std::all_of(part.sub.begin(), part.sub.end(), [this, &map_ctx](const auto &p) {
+          return render_one(p, map_ctx, true);
+        });
+      } catch (...) {
+        optional_depth--;
+        rollback(mark);
+        indent.assign(saved_indents[optional_depth]);
+
+        // (e.g. type mismatch) only an error, when the optional is not skipped anyway (cf. #else)
+        if (has_all(part.sub, map_ctx)) {
+          throw;
+        }
+        break;
+      }
+      optional_depth--;
+
+      if (full) {
+        out_newline(part.unmerged_newline);
+        add_indent({}, part.unmerged_newline);
+        if (!optional_depth) {
+          flush_warnings();
+        }
+      } else {
+        rollback(mark);
+        indent.assign(saved_indents[optional_depth]);  // (not swap: capacities would alternate between the two)
+      }
+#else
       // check whether ALL variables inside are given in map
-      const bool full = std::all_of(part.sub.begin(), part.sub.end(), [&map_ctx](const auto &p) {
-        return (p.type == part_type_e::text || p.type == part_type_e::optional || map_ctx.has(p.text_name));
-      });
+      const bool full = has_all(part.sub, map_ctx);
 
       if (full) {
         for (const auto &p : part.sub) {
@@ -149,14 +520,21 @@ void Engine::render_context_t::render_one(const part_t &part, const MapCtxT &map
         out_newline(part.unmerged_newline);
         add_indent({}, part.unmerged_newline);
       }
+#endif
     }
     break;
 
   case part_type_e::group: {
       const auto &list = map_ctx.get_list(part.text_name);
+      if (input_hash) {
+        hash_input_tag(part.text_name, list.empty() ? '-' : 'g');
+      }
       if (!list.empty()) {
         size_t i = 0;
         list.visit([this, &part, &i](const Template::detail::map_init_t &submap) {
+          if (input_hash) {
+            input_hash->update("[", 1);  // (item boundary)
+          }
           if (i++ > 0) { // add joiner
             out(part.modifiers_joiner);
             add_indent(part.modifiers_joiner);
@@ -167,18 +545,87 @@ void Engine::render_context_t::render_one(const part_t &part, const MapCtxT &map
           out_newline(part.unmerged_newline);
           add_indent({}, part.unmerged_newline);
         }
+      } else if (in_optional) {
+        return false;
       } else {
-        warn(std::string("Group Variable '").append(part.text_name).append("' not found"));
+        warn("Group Variable '", part.text_name, "' not found");
       }
     }
     break;
   }
+  return true;
 }
 
+Engine::Session::Session()
+  : ctx(std::make_unique<render_context_t>())
+{
+}
+
+Engine::Session::Session(Session &&) = default;
+Engine::Session &Engine::Session::operator=(Session &&) = default;
+Engine::Session::~Session() = default;
+
 void Engine::render(const detail::map_init_t &map) const
 {
-  render_context_t ctx;
-  ctx.render(parts, map);
+  static thread_local std::string buf;
+  buf.clear();
+  renderTo(buf, map);
+  fwrite(buf.data(), 1, buf.size(), stdout);
+}
+
+std::string Engine::toString(const detail::map_init_t &map) const
+{
+  std::string ret;
+  renderTo(ret, map);
+  return ret;
+}
+
+// used when no session is passed
+Engine::Session &Engine::default_session()
+{
+  static thread_local Session local;
+  return local;
+}
+
+void Engine::renderTo(std::string &out, const detail::map_init_t &map, Session *session) const
+{
+  (session ? *session : default_session()).ctx->render_to(out, parts, map);
+}
+
+void Engine::renderSegments(std::vector<iovec> &iov, std::string &side, const detail::map_init_t &map, Session *session) const
+{
+  (session ? *session : default_session()).ctx->render_segments(iov, side, parts, map);
+}
+
+uint64_t Engine::renderHashed(std::string &out, const detail::map_init_t &map, Session *session) const
+{
+  Hash64 hash;
+  (session ? *session : default_session()).ctx->render_to(out, parts, map, &hash);
+  return hash.digest();
+}
+
+uint64_t Engine::inputHash(const detail::map_init_t &map, Session *session) const
+{
+  Hash64 hash(identity);
+  (session ? *session : default_session()).ctx->hash_inputs(parts, map, hash);
+  return hash.digest();
+}
+
+uint64_t Engine::hash_parts(const std::vector<part_t> &parts, uint64_t seed)
+{
+  Hash64 hash(seed);
+  for (const auto &part : parts) {
+    const uint64_t head[] = {
+      (uint64_t)part.type, (uint64_t)part.unmerged_newline,
+      (uint64_t)part.number_format.style, (uint64_t)part.number_format.precision,
+      part.text_name.size(), part.modifiers_joiner.size(),
+      (part.sub.empty()) ? 0 : hash_parts(part.sub, part.sub.size())
+    };
+    hash.update(head, sizeof(head));
+    hash.update(part.text_name);
+    hash.update(part.modifiers_joiner);
+  }
+  return hash.digest();
 }
 
 void Engine::do_printvar(const std::vector<part_t> &parts, const std::string &indent)
@@ -202,5 +649,140 @@ void Engine::do_printvar(const std::vector<part_t> &parts, const std::string &in
   }
 }
 
+// names used in one map (a group opens a new one)
+struct Engine::analyze_scope_t {
+  std::set<std::string> variables, groups;
+  analysis_t::group_t *group = nullptr;  // (nullptr at top-level)
+};
+
+Engine::analysis_t Engine::analyze() const
+{
+  analysis_t ret;
+  analyze_scope_t scope;
+  do_analyze(ret, parts, scope, 0, 0, true);
+  std::set_intersection(scope.variables.begin(), scope.variables.end(), scope.groups.begin(), scope.groups.end(),
+                        std::back_inserter(ret.conflicts));
+  std::sort(ret.conflicts.begin(), ret.conflicts.end());
+  ret.conflicts.erase(std::unique(ret.conflicts.begin(), ret.conflicts.end()), ret.conflicts.end());
+  return ret;
+}
+
+// in_static: text is output by every render
+void Engine::do_analyze(analysis_t &ret, const std::vector<part_t> &parts, analyze_scope_t &scope, size_t depth, size_t group_depth, bool in_static)
+{
+  ret.max_depth = std::max(ret.max_depth, depth);
+  ret.max_group_depth = std::max(ret.max_group_depth, group_depth);
+
+  for (const auto &part : parts) {
+    const size_t newline = (part.unmerged_newline) ? 1 : 0;
+    switch (part.type) {
+    case part_type_e::text:
+      ret.text_parts++;
+      ret.static_bytes += part.text_name.size();
+      if (in_static) {
+        ret.min_bytes += part.text_name.size();
+      }
+      if (scope.group) {
+        scope.group->static_bytes_per_item += part.text_name.size();
+      }
+      break;
+
+    case part_type_e::variable:
+      ret.variable_parts++;
+      scope.variables.insert(part.text_name);
+      if (scope.group) {
+        scope.group->variables_per_item++;
+      }
+      break;
+
+    case part_type_e::optional: {
+        ret.optional_parts++;
+        ret.static_bytes += newline;
+        if (scope.group) {
+          scope.group->static_bytes_per_item += newline;
+        }
+        ret.optional_variables.push_back(std::count_if(part.sub.begin(), part.sub.end(), [](const part_t &p) {
+          return (p.type == part_type_e::variable || p.type == part_type_e::group);
+        }));
+        do_analyze(ret, part.sub, scope, depth + 1, group_depth, false);
+      }
+      break;
+
+    case part_type_e::group: {
+        ret.group_parts++;
+        ret.static_bytes += part.modifiers_joiner.size() + newline;
+        scope.groups.insert(part.text_name);
+        if (scope.group) {
+          scope.group->static_bytes_per_item += newline;
+        }
+
+        // (ret.groups might reallocate while sub is analyzed)
+        const size_t idx = ret.groups.size();
+        ret.groups.push_back({ part.text_name, group_depth + 1, part.modifiers_joiner.size(), 0 });
+
+        analyze_scope_t sub;
+        analysis_t::group_t group = ret.groups[idx];
+        sub.group = &group;
+        do_analyze(ret, part.sub, sub, depth + 1, group_depth + 1, false);
+        ret.groups[idx] = std::move(group);
+
+        std::set_intersection(sub.variables.begin(), sub.variables.end(), sub.groups.begin(), sub.groups.end(),
+                              std::back_inserter(ret.conflicts));
+      }
+      break;
+    }
+  }
+}
+
+namespace {
+void print_json_string(const std::string &str)
+{
+  putchar('"');
+  for (const char ch : str) {
+    if (ch == '"' || ch == '\\') {
+      printf("\\%c", ch);
+    } else if ((unsigned char)ch < 0x20) {
+      printf("\\u%04x", ch);
+    } else {
+      putchar(ch);
+    }
+  }
+  putchar('"');
+}
+} // namespace
+
+void Engine::printanalysis() const
+{
+  const analysis_t res = analyze();
+
+  printf("{\"parts\": {\"text\": %zu, \"variable\": %zu, \"optional\": %zu, \"group\": %zu},\n",
+         res.text_parts, res.variable_parts, res.optional_parts, res.group_parts);
+  printf(" \"static_bytes\": %zu, \"min_bytes\": %zu, \"max_depth\": %zu, \"max_group_depth\": %zu,\n",
+         res.static_bytes, res.min_bytes, res.max_depth, res.max_group_depth);
+
+  printf(" \"optional_variables\": [");
+  for (size_t i = 0; i < res.optional_variables.size(); i++) {
+    printf("%s%zu", (i) ? ", " : "", res.optional_variables[i]);
+  }
+
+  printf("],\n \"groups\": [");
+  for (size_t i = 0; i < res.groups.size(); i++) {
+    const auto &group = res.groups[i];
+    printf("%s\n  {\"name\": ", (i) ? "," : "");
+    print_json_string(group.name);
+    printf(", \"depth\": %zu, \"static_bytes_per_item\": %zu, \"variables_per_item\": %zu}",
+           group.depth, group.static_bytes_per_item, group.variables_per_item);
+  }
+
+  printf("],\n \"conflicts\": [");
+  for (size_t i = 0; i < res.conflicts.size(); i++) {
+    if (i) {
+      printf(", ");
+    }
+    print_json_string(res.conflicts[i]);
+  }
+  printf("]}\n");
+}
+
 } // namespace Template
 
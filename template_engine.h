@@ -1,22 +1,67 @@
 #pragma once
 
 #include "template_data.h"
+#include <memory>
+#include <sys/uio.h>
 
 namespace Template {
 
 struct part_t;
 
 class Engine {
+  struct render_context_t;
 public:
   Engine(std::vector<part_t> parts);
+  Engine(Engine &&);
+  Engine &operator=(Engine &&);
   ~Engine();
 
   static Engine fromString(const std::string_view &sv);
   static Engine fromFile(const char *filename);
+  // uses the compiled cachefile when it is up to date w.r.t. filename, otherwise parses and (re)writes it
+  static Engine fromCachedFile(const char *filename, const char *cachefile);
+
+  struct optimize_stats_t {
+    size_t parts_before, parts_after;
+  };
+  // NOTE: already done by fromString / fromFile
+  optimize_stats_t optimize();
+  // parts when constructed (i.e. as parsed, for fromString / fromFile) -> now
+  const optimize_stats_t &optimizeStats() const {
+    return stats;
+  }
+
+  // Scratch state (indent, ...) of rendering, kept between renders to avoid allocations in steady state.
+  // Not thread-safe: use one per thread (renderTo without session uses a thread_local one).
+  class Session {
+  public:
+    Session();
+    Session(Session &&);
+    Session &operator=(Session &&);
+    ~Session();
+
+  private:
+    friend class Engine;
+    std::unique_ptr<render_context_t> ctx;
+  };
 
   void render(const detail::map_init_t &map) const;
 
   std::string toString(const detail::map_init_t &map) const;
+
+  // appends to out (which can be pre-sized / reused by the caller)
+  void renderTo(std::string &out, const detail::map_init_t &map, Session *session = nullptr) const;
+
+  // zero-copy: replaces iov with segments pointing directly at template text and value strings (which must outlive iov),
+  // only generated content (indentation, formatted numbers, ...) is stored in side; e.g. for writev (mind IOV_MAX)
+  void renderSegments(std::vector<iovec> &iov, std::string &side, const detail::map_init_t &map, Session *session = nullptr) const;
+
+  // like renderTo, but also returns the XXH64 (seed 0) of the appended output, computed while rendering (e.g. for ETags)
+  uint64_t renderHashed(std::string &out, const detail::map_init_t &map, Session *session = nullptr) const;
+
+  // hash of the template and of all values a render would read (nothing is rendered):
+  // equal input hashes mean equal output, i.e. a cached render result can be reused
+  uint64_t inputHash(const detail::map_init_t &map, Session *session = nullptr) const;
 #if 0
   void toFile(const char *filename) const;
 #endif
@@ -25,12 +70,41 @@ public:
     do_printvar(parts);
   }
 
+  // static analysis of the compiled template (e.g. to pre-size output buffers, or to flag pathological templates)
+  struct analysis_t {
+    size_t text_parts = 0, variable_parts = 0, optional_parts = 0, group_parts = 0;
+    size_t static_bytes = 0;         // all text (+ joiners, unmerged newlines)
+    size_t min_bytes = 0;            // text outside of any optional / group, i.e. output by every render
+    size_t max_depth = 0;            // optional / group nesting
+    size_t max_group_depth = 0;
+
+    std::vector<size_t> optional_variables;  // per optional (in template order): directly required variables + groups
+
+    struct group_t {
+      std::string name;
+      size_t depth;                  // 1: top-level group
+      size_t static_bytes_per_item;  // text + joiner, not including nested groups
+      size_t variables_per_item;     // (not including nested groups)
+    };
+    std::vector<group_t> groups;     // (in template order)
+
+    std::vector<std::string> conflicts;  // names used both as variable and as group in the same map
+  };
+  analysis_t analyze() const;
+
+  // analyze() as JSON
+  void printanalysis() const;
+
 private:
+  static Session &default_session();  // (thread_local)
   static void do_printvar(const std::vector<part_t> &parts, const std::string &indent = {});
-
-  struct render_context_t;
+  struct analyze_scope_t;
+  static void do_analyze(analysis_t &ret, const std::vector<part_t> &parts, analyze_scope_t &scope, size_t depth, size_t group_depth, bool in_static);
+  static uint64_t hash_parts(const std::vector<part_t> &parts, uint64_t seed = 0);
 
   std::vector<part_t> parts;
+  uint64_t identity;                   // hash_parts(parts)
+  optimize_stats_t stats;
 };
 
 } // namespace Template
@@ -0,0 +1,119 @@
+#include "template_hash.h"
+#include <string.h>
+
+namespace Template {
+
+namespace {
+constexpr const uint64_t prime1 = 0x9e3779b185ebca87ull;
+constexpr const uint64_t prime2 = 0xc2b2ae3d27d4eb4full;
+constexpr const uint64_t prime3 = 0x165667b19e3779f9ull;
+constexpr const uint64_t prime4 = 0x85ebca77c2b2ae63ull;
+constexpr const uint64_t prime5 = 0x27d4eb2f165667c5ull;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const unsigned char *p)
+{
+  uint64_t ret;
+  memcpy(&ret, p, sizeof(ret)); // (little-endian hosts; the digest differs on big-endian)
+  return ret;
+}
+
+inline uint32_t read32(const unsigned char *p)
+{
+  uint32_t ret;
+  memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input)
+{
+  acc += input * prime2;
+  acc = rotl(acc, 31);
+  return acc * prime1;
+}
+
+inline uint64_t merge_round(uint64_t acc, uint64_t val)
+{
+  acc ^= round(0, val);
+  return acc * prime1 + prime4;
+}
+} // namespace
+
+Hash64::Hash64(uint64_t seed)
+  : v{ seed + prime1 + prime2, seed + prime2, seed, seed - prime1 },
+    seed(seed)
+{
+}
+
+void Hash64::update(const void *data, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)data, *const end = p + len;
+  total += len;
+
+  if (fill + len < sizeof(buf)) {
+    memcpy(buf + fill, p, len);
+    fill += len;
+    return;
+  }
+
+  if (fill) {
+    memcpy(buf + fill, p, sizeof(buf) - fill);
+    p += sizeof(buf) - fill;
+    for (int i = 0; i < 4; i++) {
+      v[i] = round(v[i], read64(buf + 8 * i));
+    }
+    fill = 0;
+  }
+
+  for (; end - p >= 32; p += 32) {
+    for (int i = 0; i < 4; i++) {
+      v[i] = round(v[i], read64(p + 8 * i));
+    }
+  }
+
+  fill = end - p;
+  memcpy(buf, p, fill);
+}
+
+uint64_t Hash64::digest() const
+{
+  uint64_t h;
+  if (total >= 32) {
+    h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+    for (int i = 0; i < 4; i++) {
+      h = merge_round(h, v[i]);
+    }
+  } else {
+    h = seed + prime5;
+  }
+  h += total;
+
+  const unsigned char *p = buf, *const end = buf + fill;
+  for (; end - p >= 8; p += 8) {
+    h ^= round(0, read64(p));
+    h = rotl(h, 27) * prime1 + prime4;
+  }
+  if (end - p >= 4) {
+    h ^= (uint64_t)read32(p) * prime1;
+    h = rotl(h, 23) * prime2 + prime3;
+    p += 4;
+  }
+  for (; p < end; p++) {
+    h ^= (*p) * prime5;
+    h = rotl(h, 11) * prime1;
+  }
+
+  h ^= h >> 33;
+  h *= prime2;
+  h ^= h >> 29;
+  h *= prime3;
+  h ^= h >> 32;
+  return h;
+}
+
+} // namespace Template
+
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string_view>
+#include <stdint.h>
+
+namespace Template {
+
+// streaming XXH64 (non-cryptographic; e.g. for ETags / cache keys)
+class Hash64 {
+public:
+  explicit Hash64(uint64_t seed = 0);
+
+  void update(const void *data, size_t len);
+  void update(std::string_view sv) {
+    update(sv.data(), sv.size());
+  }
+
+  uint64_t digest() const;
+
+private:
+  uint64_t v[4];
+  uint64_t seed;
+  uint64_t total = 0;
+  unsigned char buf[32];
+  size_t fill = 0;
+};
+
+} // namespace Template
+
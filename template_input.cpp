@@ -1,7 +1,12 @@
 #include "template_input.h"
 #include <system_error>
+#include <string>
 #include <stdexcept>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace Template {
 
@@ -81,5 +86,52 @@ size_t FileInput::_read(char *buf, size_t len)
   return fread(buf, 1, len, f);
 }
 
+
+MappedFile::MappedFile(const char *filename)
+{
+  const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr != MAP_FAILED) {
+      data = (const char *)ptr;
+      size = st.st_size;
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (data) {
+    munmap((void *)data, size);
+  }
+}
+
+void write_file_atomic(const char *filename, std::initializer_list<std::string_view> chunks)
+{
+  const std::string tmpname = std::string(filename).append(".tmp.").append(std::to_string(getpid()));
+  FILE *f = fopen(tmpname.c_str(), "wb");
+  if (!f) {
+    throw std::system_error(errno, std::generic_category(), std::string("Failed to open file: ").append(tmpname));
+  }
+  bool ok = true;
+  for (const auto &chunk : chunks) {
+    ok = ok && (chunk.empty() || fwrite(chunk.data(), 1, chunk.size(), f) == chunk.size());
+  }
+  if (fclose(f) != 0 || !ok) {
+    unlink(tmpname.c_str());
+    throw std::runtime_error(std::string("Failed to write file: ").append(tmpname));
+  }
+  if (rename(tmpname.c_str(), filename) != 0) {
+    const int err = errno;
+    unlink(tmpname.c_str());
+    throw std::system_error(err, std::generic_category(), std::string("Failed to rename to: ").append(filename));
+  }
+}
+
 } // namespace Template
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string_view>
+#include <initializer_list>
+#include <stdint.h>
+#include <stdio.h>
 
 namespace Template {
 
@@ -42,5 +45,29 @@ private:
   FILE *f;
 };
 
+// read-only, shared mapping of a whole file (data == nullptr, when it could not be mapped or is empty)
+class MappedFile {
+public:
+  MappedFile(const char *filename);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  const char *data = nullptr;
+  size_t size = 0;
+};
+
+// (e.g. for checksums of cache / snapshot files)
+inline uint64_t fnv1a(const char *data, size_t len, uint64_t hash = 0xcbf29ce484222325ull)
+{
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ (unsigned char)data[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// atomically replaces filename by chunks (written to a temporary file + rename); throws on error
+void write_file_atomic(const char *filename, std::initializer_list<std::string_view> chunks);
+
 } // namespace Template
 
@@ -0,0 +1,361 @@
+#include "template_json.h"
+#include "template_input.h"
+#include <stdexcept>
+#include <string.h>
+
+namespace Template {
+
+namespace {
+class JsonParser {
+public:
+  JsonParser(std::string_view json, detail::JsonHandler &handler)
+    : pos(json.data()), end(json.data() + json.size()), handler(handler) { }
+
+  void run() {
+    skip_ws();
+    value(0);
+    skip_ws();
+    if (pos != end) {
+      error("Trailing characters");
+    }
+  }
+
+private:
+  [[noreturn]] void error(const char *msg) const {
+    throw std::runtime_error(std::string("JSON: ").append(msg));
+  }
+
+  void skip_ws() {
+    while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+      ++pos;
+    }
+  }
+
+  void expect(std::string_view lit) {
+    if ((size_t)(end - pos) < lit.size() || memcmp(pos, lit.data(), lit.size()) != 0) {
+      error("Unexpected character");
+    }
+    pos += lit.size();
+  }
+
+  void value(unsigned int depth) {
+    if (pos == end) {
+      error("Unexpected end of input");
+    } else if (depth > 512) {
+      error("Nesting too deep");
+    }
+
+    switch (*pos) {
+    case '{':
+      ++pos;
+      handler.begin_object();
+      skip_ws();
+      if (pos != end && *pos == '}') {
+        ++pos;
+      } else {
+        while (true) {
+          skip_ws();
+          if (pos == end || *pos != '"') {
+            error("Expected key");
+          }
+          handler.key(string());
+          skip_ws();
+          expect(":");
+          skip_ws();
+          value(depth + 1);
+          skip_ws();
+          if (pos != end && *pos == ',') {
+            ++pos;
+          } else {
+            expect("}");
+            break;
+          }
+        }
+      }
+      handler.end_object();
+      break;
+
+    case '[':
+      ++pos;
+      handler.begin_array();
+      skip_ws();
+      if (pos != end && *pos == ']') {
+        ++pos;
+      } else {
+        while (true) {
+          skip_ws();
+          value(depth + 1);
+          skip_ws();
+          if (pos != end && *pos == ',') {
+            ++pos;
+          } else {
+            expect("]");
+            break;
+          }
+        }
+      }
+      handler.end_array();
+      break;
+
+    case '"':
+      handler.string(string());
+      break;
+
+    case 't':
+      expect("true");
+      handler.boolean(true);
+      break;
+
+    case 'f':
+      expect("false");
+      handler.boolean(false);
+      break;
+
+    case 'n':
+      expect("null");
+      handler.null();
+      break;
+
+    default:
+      handler.number(number());
+      break;
+    }
+  }
+
+  // returns view into input, when no escapes are present; otherwise into scratch
+  std::string_view string() {
+    // assert(*pos == '"');
+    const char *start = ++pos;
+    while (pos != end && *pos != '"' && *pos != '\\') {
+      if ((unsigned char)*pos < 0x20) {
+        error("Control character in string");
+      }
+      ++pos;
+    }
+    if (pos == end) {
+      error("Unterminated string");
+    } else if (*pos == '"') {
+      return { start, (size_t)(pos++ - start) };
+    }
+
+    scratch.assign(start, pos);
+    while (true) {
+      if (pos == end) {
+        error("Unterminated string");
+      }
+      const char ch = *pos++;
+      if (ch == '"') {
+        return scratch;
+      } else if ((unsigned char)ch < 0x20) {
+        error("Control character in string");
+      } else if (ch != '\\') {
+        scratch.push_back(ch);
+        continue;
+      } else if (pos == end) {
+        error("Unterminated string");
+      }
+
+      switch (*pos++) {
+      case '"': scratch.push_back('"'); break;
+      case '\\': scratch.push_back('\\'); break;
+      case '/': scratch.push_back('/'); break;
+      case 'b': scratch.push_back('\b'); break;
+      case 'f': scratch.push_back('\f'); break;
+      case 'n': scratch.push_back('\n'); break;
+      case 'r': scratch.push_back('\r'); break;
+      case 't': scratch.push_back('\t'); break;
+      case 'u': {
+          unsigned int cp = hex4();
+          if (cp >= 0xd800 && cp < 0xdc00) { // surrogate pair
+            expect("\\u");
+            const unsigned int lo = hex4();
+            if (lo < 0xdc00 || lo >= 0xe000) {
+              error("Bad surrogate pair");
+            }
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+          } else if (cp >= 0xdc00 && cp < 0xe000) {
+            error("Bad surrogate pair");
+          }
+          put_utf8(cp);
+        }
+        break;
+      default:
+        error("Bad escape sequence");
+      }
+    }
+  }
+
+  unsigned int hex4() {
+    if (end - pos < 4) {
+      error("Bad \\u escape");
+    }
+    unsigned int ret = 0;
+    for (int i = 0; i < 4; i++) {
+      const char ch = *pos++;
+      ret <<= 4;
+      if (ch >= '0' && ch <= '9') {
+        ret |= ch - '0';
+      } else if (ch >= 'a' && ch <= 'f') {
+        ret |= ch - 'a' + 10;
+      } else if (ch >= 'A' && ch <= 'F') {
+        ret |= ch - 'A' + 10;
+      } else {
+        error("Bad \\u escape");
+      }
+    }
+    return ret;
+  }
+
+  void put_utf8(unsigned int cp) {
+    if (cp < 0x80) {
+      scratch.push_back(cp);
+    } else if (cp < 0x800) {
+      scratch.push_back(0xc0 | (cp >> 6));
+      scratch.push_back(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+      scratch.push_back(0xe0 | (cp >> 12));
+      scratch.push_back(0x80 | ((cp >> 6) & 0x3f));
+      scratch.push_back(0x80 | (cp & 0x3f));
+    } else {
+      scratch.push_back(0xf0 | (cp >> 18));
+      scratch.push_back(0x80 | ((cp >> 12) & 0x3f));
+      scratch.push_back(0x80 | ((cp >> 6) & 0x3f));
+      scratch.push_back(0x80 | (cp & 0x3f));
+    }
+  }
+
+  std::string_view number() {
+    const char *start = pos;
+    auto digits = [this]() {
+      const char *p = pos;
+      while (pos != end && *pos >= '0' && *pos <= '9') {
+        ++pos;
+      }
+      return (pos != p);
+    };
+
+    if (pos != end && *pos == '-') {
+      ++pos;
+    }
+    if (pos != end && *pos == '0') {
+      ++pos;
+    } else if (!digits()) {
+      error("Unexpected character");
+    }
+    if (pos != end && *pos == '.') {
+      ++pos;
+      if (!digits()) {
+        error("Bad number");
+      }
+    }
+    if (pos != end && (*pos == 'e' || *pos == 'E')) {
+      ++pos;
+      if (pos != end && (*pos == '+' || *pos == '-')) {
+        ++pos;
+      }
+      if (!digits()) {
+        error("Bad number");
+      }
+    }
+    return { start, (size_t)(pos - start) };
+  }
+
+  const char *pos, *end;
+  detail::JsonHandler &handler;
+  std::string scratch;
+};
+
+class DataBuilder final : public detail::JsonHandler {
+public:
+  void begin_object() override {
+    if (!stack.empty()) {
+      value_check();
+    }
+    stack.push_back({ Data{}, {}, false });
+  }
+  void key(std::string_view key) override {
+    stack.back().key.assign(key);
+  }
+  void end_object() override {
+    if (stack.size() > 1) {
+      frame_t child = std::move(stack.back());
+      stack.pop_back();
+      stack.back().data.add_list(stack.back().key, std::move(child.data));
+    }
+  }
+
+  void begin_array() override {
+    if (stack.empty()) {
+      throw std::runtime_error("JSON: top-level value must be an object");
+    } else if (stack.back().in_array) {
+      throw std::runtime_error("JSON: nested arrays are not supported");
+    }
+    stack.back().in_array = true;
+    stack.back().data.set(stack.back().key, {}); // (empty array -> empty group)
+  }
+  void end_array() override {
+    stack.back().in_array = false;
+  }
+
+  void string(std::string_view value) override {
+    value_check();
+    if (stack.back().in_array) {
+      throw std::runtime_error(std::string("JSON: array '").append(stack.back().key).append("' must only contain objects"));
+    }
+    stack.back().data.set(stack.back().key, value);
+  }
+  void number(std::string_view raw) override {
+    string(raw);
+  }
+  void boolean(bool value) override {
+    string(value ? "true" : "false");
+  }
+  void null() override {
+    value_check();
+  }
+
+  Data get() {
+    // assert(stack.size() == 1);
+    return std::move(stack.back().data);
+  }
+
+private:
+  void value_check() const {
+    if (stack.empty()) {
+      throw std::runtime_error("JSON: top-level value must be an object");
+    }
+  }
+
+  struct frame_t {
+    Data data;
+    std::string key;    // current key (in data)
+    bool in_array;      // whether values are elements of an array at key
+  };
+  std::vector<frame_t> stack;
+};
+} // namespace
+
+void detail::parse_json(std::string_view json, detail::JsonHandler &handler)
+{
+  JsonParser(json, handler).run();
+}
+
+Data parse_json_string(std::string_view json)
+{
+  DataBuilder builder;
+  detail::parse_json(json, builder);
+  return builder.get();
+}
+
+Data parse_json_file(const char *filename)
+{
+  FileInput in(filename);
+  std::string json;
+  for (auto sv = in.get(); !sv.empty(); sv = in.get(sv.size())) {
+    json.append(sv);
+  }
+  return parse_json_string(json);
+}
+
+} // namespace Template
+
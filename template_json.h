@@ -0,0 +1,38 @@
+#pragma once
+
+#include "template_data.h"
+
+namespace Template {
+
+namespace detail {
+// SAX-style events; string_views are only valid during the call
+class JsonHandler {
+public:
+  virtual ~JsonHandler() {}
+
+  virtual void begin_object() = 0;
+  virtual void key(std::string_view key) = 0;
+  virtual void end_object() = 0;
+
+  virtual void begin_array() = 0;
+  virtual void end_array() = 0;
+
+  virtual void string(std::string_view value) = 0;
+  virtual void number(std::string_view raw) = 0;  // (validated, but unconverted)
+  virtual void boolean(bool value) = 0;
+  virtual void null() = 0;
+};
+
+void parse_json(std::string_view json, JsonHandler &handler);
+} // namespace detail
+
+// Builds Data directly (no intermediate DOM):
+//  - the top-level value must be an object,
+//  - strings, numbers (as written) and booleans ("true"/"false") become strings, null values are skipped,
+//  - arrays must contain objects (or null) and become groups (an empty array is an empty group),
+//  - nested objects become single-item groups.
+Data parse_json_string(std::string_view json);
+Data parse_json_file(const char *filename);
+
+} // namespace Template
+
@@ -0,0 +1,129 @@
+#include "template_loader.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <system_error>
+#include <thread>
+
+namespace Template {
+
+namespace {
+LoadResult load(const std::vector<std::pair<std::string, std::string>> &files, unsigned int threads) // (name, filename)
+{
+  // start with the largest files, so the total time is roughly that of the largest one
+  std::vector<std::pair<uintmax_t, size_t>> order;
+  order.reserve(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(files[i].second, ec);
+    order.emplace_back(ec ? 0 : size, i);
+  }
+  std::sort(order.begin(), order.end(), [](const auto &a, const auto &b) {
+    return a.first > b.first;
+  });
+
+  std::vector<std::optional<Engine>> engines(files.size());
+  std::vector<std::string> errors(files.size());
+  std::atomic<size_t> next{0};
+
+  auto worker = [&]() {
+    for (size_t j; (j = next.fetch_add(1)) < order.size(); ) {
+      const size_t i = order[j].second;
+      try {
+        engines[i].emplace(Engine::fromFile(files[i].second.c_str()));
+      } catch (std::exception &e) {
+        errors[i] = e.what();
+        if (errors[i].empty()) {
+          errors[i] = "Unknown error";
+        }
+      }
+    }
+  };
+
+  if (!threads) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  threads = std::min<size_t>(threads, files.size());
+  if (threads > 1) {
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned int k = 1; k < threads; k++) {
+      pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : pool) {
+      t.join();
+    }
+  } else {
+    worker();
+  }
+
+  LoadResult ret;
+  ret.engines.reserve(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    if (engines[i]) {
+      if (!ret.engines.emplace(files[i].first, std::move(*engines[i])).second) {
+        ret.errors.emplace_back(files[i].first, "Duplicate template name");
+      }
+    } else {
+      ret.errors.emplace_back(files[i].first, std::move(errors[i]));
+    }
+  }
+  return ret;
+}
+} // namespace
+
+LoadResult loadFiles(const std::vector<std::string> &filenames, unsigned int threads)
+{
+  std::vector<std::pair<std::string, std::string>> files;
+  files.reserve(filenames.size());
+  for (const auto &filename : filenames) {
+    files.emplace_back(filename, filename);
+  }
+  return load(files, threads);
+}
+
+LoadResult loadDirectory(const char *dirname, const std::string_view &extension, unsigned int threads)
+{
+  namespace fs = std::filesystem;
+  std::vector<std::pair<std::string, std::string>> files;
+  const fs::path base(dirname);
+  for (const auto &entry : fs::recursive_directory_iterator(base)) {  // throws fs::filesystem_error
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    const fs::path &path = entry.path();
+    if (!extension.empty() && path.extension() != extension) {
+      continue;
+    }
+    files.emplace_back(path.lexically_relative(base).generic_string(), path.string());
+  }
+  return load(files, threads);
+}
+
+LoadResult loadManifest(const char *filename, unsigned int threads)
+{
+  namespace fs = std::filesystem;
+  std::ifstream in(filename);
+  if (!in) {
+    throw std::system_error(errno, std::generic_category(), std::string("Failed to open file: ").append(filename));
+  }
+
+  const fs::path base = fs::path(filename).parent_path();
+  std::vector<std::pair<std::string, std::string>> files;
+  for (std::string line; std::getline(in, line); ) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    files.emplace_back(line, (base / line).string());
+  }
+  return load(files, threads);
+}
+
+} // namespace Template
+
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "template_engine.h"
+#include <unordered_map>
+#include <string>
+#include <vector>
+
+namespace Template {
+
+struct LoadResult {
+  std::unordered_map<std::string, Engine> engines;           // name -> Engine
+  std::vector<std::pair<std::string, std::string>> errors;   // (name, message), one per failed file
+};
+
+// parses all files in parallel (threads == 0: std::thread::hardware_concurrency());
+// does not stop at the first error
+LoadResult loadFiles(const std::vector<std::string> &filenames, unsigned int threads = 0);
+
+// names are relative to dirname (recursive)
+LoadResult loadDirectory(const char *dirname, const std::string_view &extension = ".tmpl", unsigned int threads = 0);
+
+// manifest: one filename per line (relative to the manifest's directory), empty lines and '#'-lines are ignored
+LoadResult loadManifest(const char *filename, unsigned int threads = 0);
+
+} // namespace Template
+
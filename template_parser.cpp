@@ -92,7 +92,7 @@ void parse_command(std::string_view &sv, detail::Builder &tb)
     if (mpos < pos) { // (esp. != npos)
       tb.variable(sv.substr(1, mpos - 1), sv.substr(mpos + 1, pos - mpos - 1));
     } else {
-      tb.variable(sv.substr(1, pos));
+      tb.variable(sv.substr(1, pos - 1));
     }
     sv.remove_prefix(pos + 1);
 
@@ -130,6 +130,37 @@ void detail::parse(Input &&in, detail::Builder &tb)
   tb.finish();
 }
 
+number_format_t parse_number_format(std::string_view modifiers)
+{
+  static constexpr const struct {
+    std::string_view prefix;
+    number_format_t::style_e style;
+  } styles[] = {
+    { "fixed", number_format_t::style_e::fixed },
+    { "sci", number_format_t::style_e::scientific },
+    { "prec", number_format_t::style_e::general },
+    { "hex", number_format_t::style_e::hex }
+  };
+
+  number_format_t ret;
+  for (const auto &it : styles) {
+    if (modifiers.substr(0, it.prefix.size()) != it.prefix) {
+      continue;
+    }
+    const std::string_view digits = modifiers.substr(it.prefix.size());
+    if (digits.size() > 2 || (!digits.empty() && it.style == number_format_t::style_e::hex) ||
+        digits.find_first_not_of("0123456789") != digits.npos) {
+      break; // not a numeric modifier
+    }
+    ret.style = it.style;
+    if (!digits.empty()) {
+      ret.precision = std::stoi(std::string(digits));
+    }
+    break;
+  }
+  return ret;
+}
+
 // ---
 
 namespace {
@@ -251,5 +282,84 @@ std::vector<part_t> parse_file(const char *filename)
   return builder.get();
 }
 
+// ---
+
+namespace {
+// optional is always rendered, when it contains only text and (nested) optionals, cf. Engine::render_context_t
+bool is_static_optional(const part_t &part)
+{
+  // assert(part.type == part_type_e::optional);
+  for (const auto &p : part.sub) {
+    if (p.type != part_type_e::text && p.type != part_type_e::optional) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void append_text(std::vector<part_t> &ret, std::string_view text)
+{
+  if (text.empty()) {
+    return;
+  } else if (!ret.empty() && ret.back().type == part_type_e::text) {
+    ret.back().text_name.append(text);
+  } else {
+    ret.emplace_back(part_type_e::text, text);
+  }
+}
+
+void append_part(std::vector<part_t> &ret, part_t &&part)
+{
+  switch (part.type) {
+  case part_type_e::text:
+    append_text(ret, part.text_name);
+    break;
+
+  case part_type_e::variable:
+    ret.push_back(std::move(part));
+    break;
+
+  case part_type_e::optional:
+    optimize_parts(part.sub);
+    if (is_static_optional(part)) {
+      // flatten: same output, and unmerged_newline resets indent just like a text ending in '\n'
+      for (auto &p : part.sub) {
+        append_part(ret, std::move(p));
+      }
+      if (part.unmerged_newline) {
+        append_text(ret, { &part.unmerged_newline, 1 });
+      }
+    } else {
+      ret.push_back(std::move(part));
+    }
+    break;
+
+  case part_type_e::group:
+    optimize_parts(part.sub);
+    ret.push_back(std::move(part));
+    break;
+  }
+}
+} // namespace
+
+void optimize_parts(std::vector<part_t> &parts)
+{
+  std::vector<part_t> ret;
+  ret.reserve(parts.size());
+  for (auto &part : parts) {
+    append_part(ret, std::move(part));
+  }
+  parts = std::move(ret);
+}
+
+size_t count_parts(const std::vector<part_t> &parts)
+{
+  size_t ret = parts.size();
+  for (const auto &part : parts) {
+    ret += count_parts(part.sub);
+  }
+  return ret;
+}
+
 } // namespace Template
 
@@ -30,20 +30,45 @@ enum struct part_type_e : char {
   text, variable, optional, group
 };
 
+// formatting of numeric values, resolved from variable modifiers at compile time:
+//   fixed<N>, sci<N>, prec<N> (general), hex   (N: 0..99, optional); other modifiers: shortest round-trip
+struct number_format_t {
+  enum struct style_e : char {
+    shortest, fixed, scientific, general, hex
+  };
+  style_e style = style_e::shortest;
+  int precision = -1;                  // -1: none
+};
+
+number_format_t parse_number_format(std::string_view modifiers);
+
 struct part_t {
   part_t(part_type_e type, std::string_view text_name = {}, std::string_view modifiers_joiner = {})
     : text_name(text_name), modifiers_joiner(modifiers_joiner), type(type)
-  { }
+  {
+    if (type == part_type_e::variable) {
+      number_format = parse_number_format(modifiers_joiner);
+    }
+  }
 
   std::string text_name;               // for text: text, for variable/group: name (not used for optional)
   std::string modifiers_joiner;        // for variable: modifiers, for group: joiner (not used for optional)
   std::vector<part_t> sub;             // only for optional/group
+  number_format_t number_format;       // only for variable
   part_type_e type;
   char unmerged_newline = 0;           // for optional/group
 };
 
+// bump whenever parse_* / optimize_parts produce different parts for the same source (invalidates template caches)
+//   2: ${var} no longer includes '}' in the name
+constexpr const uint32_t parser_version = 2;
+
 std::vector<part_t> parse_string(const std::string_view &sv);
 std::vector<part_t> parse_file(const char *filename);
 
+// merges adjacent text, reduces optionals without (direct) variables/groups to their contents
+void optimize_parts(std::vector<part_t> &parts);
+size_t count_parts(const std::vector<part_t> &parts);  // (recursive)
+
 } // namespace Template
 
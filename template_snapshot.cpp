@@ -0,0 +1,325 @@
+#include "template_snapshot.h"
+#include <system_error>
+#include <stdexcept>
+
+namespace Template {
+
+namespace {
+constexpr const char magic[8] = { 'T', 'M', 'P', 'L', 'S', 'N', 'A', 'P' };
+constexpr const uint32_t format_version = 1;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;           // 0x01020304 (native)
+  uint64_t checksum;         // over everything after the header
+  uint32_t nodes_size;       // nodes directly follow the header
+  uint32_t pool_size;        // pool directly follows the nodes
+  uint32_t root;             // offset of root map (in nodes)
+  uint32_t reserved;
+};
+
+static_assert(sizeof(header_t) == 40, "unexpected padding");
+
+// map:  uint32_t slots (0 or power of 2); snapshot_entry_t entry[slots];
+// list: uint32_t count; uint32_t map[count];
+enum struct entry_type_e : uint8_t {
+  empty, string, list, number
+};
+
+uint32_t hash_key(std::string_view key)
+{
+  return (uint32_t)fnv1a(key.data(), key.size());
+}
+
+uint32_t check32(size_t value)
+{
+  if (value > UINT32_MAX) {
+    throw std::length_error("Snapshot too large");
+  }
+  return value;
+}
+} // namespace
+
+struct detail::snapshot_entry_t {
+  uint32_t hash;
+  uint32_t key_offset, key_size;      // in pool
+  uint32_t value_offset, value_size;  // string: in pool; list: value_offset in nodes; number: low / high 32 bits
+  entry_type_e type;
+  uint8_t single_line;                // string: bool; number: number_t::type_e
+  uint16_t reserved;
+};
+
+static_assert(sizeof(detail::snapshot_entry_t) == 24, "unexpected padding");
+
+namespace {
+detail::number_t get_number(const detail::snapshot_entry_t &entry)
+{
+  // (check the raw byte: type_e is char-based, i.e. possibly signed)
+  if (entry.single_line < (uint8_t)detail::number_t::type_e::boolean || entry.single_line > (uint8_t)detail::number_t::type_e::float64) {
+    throw std::runtime_error("Corrupt snapshot: bad number type");
+  }
+  detail::number_t ret;
+  ret.type = (detail::number_t::type_e)entry.single_line;
+  const uint64_t bits = entry.value_offset | ((uint64_t)entry.value_size << 32);
+  static_assert(sizeof(bits) == sizeof(ret.u), "");
+  memcpy(&ret.u, &bits, sizeof(bits));
+  return ret;
+}
+
+void set_number(detail::snapshot_entry_t &entry, const detail::number_t &number)
+{
+  uint64_t bits;
+  memcpy(&bits, &number.u, sizeof(bits));
+  entry.value_offset = (uint32_t)bits;
+  entry.value_size = (uint32_t)(bits >> 32);
+  entry.single_line = (uint8_t)number.type;
+}
+} // namespace
+
+Snapshot::Snapshot(const char *filename, bool verify_checksum)
+  : file(filename)
+{
+  if (!file.data) {
+    throw std::system_error(errno, std::generic_category(), std::string("Failed to map file: ").append(filename));
+  }
+
+  header_t hdr;
+  if (file.size < sizeof(hdr) ||
+      (memcpy(&hdr, file.data, sizeof(hdr)), memcmp(hdr.magic, magic, sizeof(magic)) != 0)) {
+    throw std::runtime_error(std::string("Not a snapshot file: ").append(filename));
+  } else if (hdr.version != format_version || hdr.endian != 0x01020304) {
+    throw std::runtime_error(std::string("Unsupported snapshot format: ").append(filename));
+  } else if (file.size != sizeof(hdr) + (uint64_t)hdr.nodes_size + hdr.pool_size ||
+             (hdr.nodes_size & 3) != 0 ||
+             (verify_checksum && fnv1a(file.data + sizeof(hdr), file.size - sizeof(hdr)) != hdr.checksum)) {
+    throw std::runtime_error(std::string("Corrupt snapshot file: ").append(filename));
+  }
+
+  nodes = file.data + sizeof(hdr);
+  nodes_size = hdr.nodes_size;
+  pool = nodes + nodes_size;
+  pool_size = hdr.pool_size;
+  root = hdr.root;
+  node(root, sizeof(uint32_t));
+}
+
+const char *Snapshot::node(uint32_t offset, size_t size) const
+{
+  if ((offset & 3) != 0 || offset > nodes_size || size > nodes_size - offset) {
+    throw std::runtime_error("Corrupt snapshot: bad node offset");
+  }
+  return nodes + offset;
+}
+
+std::string_view Snapshot::string(uint32_t offset, uint32_t size) const
+{
+  if (offset > pool_size || size > pool_size - offset) {
+    throw std::runtime_error("Corrupt snapshot: bad string offset");
+  }
+  return { pool + offset, size };
+}
+
+const detail::snapshot_entry_t *Snapshot::find(uint32_t map, std::string_view key) const
+{
+  const uint32_t slots = *(const uint32_t *)node(map, sizeof(uint32_t));
+  if (!slots) {
+    return nullptr;
+  }
+  const auto *entries = (const detail::snapshot_entry_t *)node(map + sizeof(uint32_t), (size_t)slots * sizeof(detail::snapshot_entry_t));
+
+  const uint32_t hash = hash_key(key);
+  for (uint32_t i = 0, pos = hash & (slots - 1); i < slots; i++, pos = (pos + 1) & (slots - 1)) {
+    const auto &entry = entries[pos];
+    if (entry.type == entry_type_e::empty) {
+      return nullptr;
+    } else if (entry.hash == hash && string(entry.key_offset, entry.key_size) == key) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+detail::map_init_t::map_init_t(const Snapshot &snapshot)
+  : snapshot(&snapshot), snapshot_offset(snapshot.root)
+{
+}
+
+// ---
+
+bool detail::snapshot_map_ctx_t::has(const std::string &name) const
+{
+  return snapshot.find(offset, name);
+}
+
+detail::string_ref_t detail::snapshot_map_ctx_t::get_string(const std::string &name) const
+{
+  const detail::snapshot_entry_t *entry = snapshot.find(offset, name);
+  if (!entry) {
+    return {}; // -> (!.found())
+  } else if (entry->type == entry_type_e::number) {
+    return { {}, nullptr, get_number(*entry) };
+  } else if (entry->type != entry_type_e::string) {
+    throw std::runtime_error(std::string("Expected String, got List for variable '").append(name).append("'"));
+  }
+  return { snapshot.string(entry->value_offset, entry->value_size), entry->single_line ? &string_info_t::single_line : nullptr };
+}
+
+detail::list_init_t detail::snapshot_map_ctx_t::get_list(const std::string &name) const
+{
+  const detail::snapshot_entry_t *entry = snapshot.find(offset, name);
+  if (!entry) {
+    return {}; // -> (.empty())
+  } else if (entry->type != entry_type_e::list) {
+    throw std::runtime_error(std::string("Expected List, got String for group '").append(name).append("'"));
+  }
+  return { snapshot, entry->value_offset };
+}
+
+size_t detail::snapshot_list_size(const Snapshot &snapshot, uint32_t list)
+{
+  return *(const uint32_t *)snapshot.node(list, sizeof(uint32_t));
+}
+
+uint32_t detail::snapshot_list_item(const Snapshot &snapshot, uint32_t list, size_t index)
+{
+  // assert(index < snapshot_list_size(snapshot, list));
+  return *(const uint32_t *)snapshot.node(list + sizeof(uint32_t) * (1 + index), sizeof(uint32_t));
+}
+
+size_t detail::snapshot_map_slots(const Snapshot &snapshot, uint32_t map)
+{
+  return *(const uint32_t *)snapshot.node(map, sizeof(uint32_t));
+}
+
+bool detail::snapshot_map_slot(const Snapshot &snapshot, uint32_t map, size_t slot, std::string_view &key, std::string_view &string, number_t &number, uint32_t &list)
+{
+  const detail::snapshot_entry_t &entry = *(const detail::snapshot_entry_t *)snapshot.node(map + sizeof(uint32_t) + slot * sizeof(detail::snapshot_entry_t), sizeof(detail::snapshot_entry_t));
+  if (entry.type == entry_type_e::empty) {
+    return false;
+  }
+  key = snapshot.string(entry.key_offset, entry.key_size);
+  string = {};
+  number = {};
+  if (entry.type == entry_type_e::string) {
+    string = snapshot.string(entry.value_offset, entry.value_size);
+  } else if (entry.type == entry_type_e::number) {
+    number = get_number(entry);
+  } else {
+    list = entry.value_offset;
+  }
+  return true;
+}
+
+// ---
+
+namespace {
+class SnapshotWriter {
+public:
+  std::string nodes, pool;
+
+  uint32_t add_map(const detail::map_init_t &map) {
+    std::vector<detail::snapshot_entry_t> entries;
+    map.visit(Visitor{ *this, entries });
+
+    uint32_t slots = 0;
+    if (!entries.empty()) {
+      for (slots = 1; slots < 2 * entries.size(); slots <<= 1) { }  // load factor <= 0.5
+    }
+    std::vector<detail::snapshot_entry_t> table(slots, detail::snapshot_entry_t{});
+    for (const auto &entry : entries) {
+      uint32_t pos = entry.hash & (slots - 1);
+      while (table[pos].type != entry_type_e::empty) {
+        pos = (pos + 1) & (slots - 1);
+      }
+      table[pos] = entry;
+    }
+
+    const uint32_t ret = check32(nodes.size());
+    nodes.append((const char *)&slots, sizeof(slots));
+    nodes.append((const char *)table.data(), table.size() * sizeof(detail::snapshot_entry_t));
+    return ret;
+  }
+
+private:
+  struct Visitor {
+    SnapshotWriter &writer;
+    std::vector<detail::snapshot_entry_t> &entries;
+
+    void operator()(std::string_view key, std::string_view value) {
+      auto &entry = add(key);
+      entry.type = entry_type_e::string;
+      entry.value_offset = writer.add_string(value);
+      entry.value_size = check32(value.size());
+      entry.single_line = (value.find('\n') == value.npos);
+    }
+
+    void operator()(std::string_view key, const detail::number_t &value) {
+      auto &entry = add(key);
+      entry.type = entry_type_e::number;
+      set_number(entry, value);
+    }
+
+    void operator()(std::string_view key, const detail::list_init_t &value) {
+      std::vector<uint32_t> items;
+      value.visit([this, &items](const detail::map_init_t &map) {
+        items.push_back(writer.add_map(map));
+      });
+
+      auto &entry = add(key);
+      entry.type = entry_type_e::list;
+      entry.value_offset = check32(writer.nodes.size());
+      const uint32_t count = check32(items.size());
+      writer.nodes.append((const char *)&count, sizeof(count));
+      writer.nodes.append((const char *)items.data(), items.size() * sizeof(uint32_t));
+    }
+
+    detail::snapshot_entry_t &add(std::string_view key) {
+      auto &entry = entries.emplace_back();
+      entry.hash = hash_key(key);
+      entry.key_offset = writer.add_key(key);
+      entry.key_size = check32(key.size());
+      return entry;
+    }
+  };
+
+  uint32_t add_string(std::string_view str) {
+    const uint32_t ret = check32(pool.size());
+    pool.append(str);
+    check32(pool.size());
+    return ret;
+  }
+
+  uint32_t add_key(std::string_view key) { // (deduplicated)
+    auto it = keys.find(std::string(key));
+    if (it == keys.end()) {
+      it = keys.emplace(key, add_string(key)).first;
+    }
+    return it->second;
+  }
+
+  std::unordered_map<std::string, uint32_t> keys;
+};
+} // namespace
+
+void Snapshot::write(const detail::map_init_t &data, const char *filename)
+{
+  SnapshotWriter writer;
+  header_t hdr = {};
+  memcpy(hdr.magic, magic, sizeof(magic));
+  hdr.version = format_version;
+  hdr.endian = 0x01020304;
+  hdr.root = writer.add_map(data);
+  hdr.nodes_size = check32(writer.nodes.size());
+  hdr.pool_size = check32(writer.pool.size());
+  hdr.checksum = fnv1a(writer.pool.data(), writer.pool.size(), fnv1a(writer.nodes.data(), writer.nodes.size()));
+
+  write_file_atomic(filename, {
+    { (const char *)&hdr, sizeof(hdr) },
+    { writer.nodes.data(), writer.nodes.size() },
+    { writer.pool.data(), writer.pool.size() }
+  });
+}
+
+} // namespace Template
+
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "template_data.h"
+#include "template_input.h"
+
+namespace Template {
+
+namespace detail {
+struct snapshot_entry_t;
+} // namespace detail
+
+// Read-only, memory-mapped Data snapshot (e.g. large reference data shared by many processes):
+//   header, nodes (maps: open addressing hash tables; lists: arrays of map offsets), string pool.
+// Lookups read directly from the mapped file; use as map_init_t (i.e. wherever Data is accepted).
+// NOTE: the format is native-endian, files are not portable between architectures.
+class Snapshot {
+public:
+  // throws on error; verify_checksum: read the whole file once (otherwise only header / bounds are checked)
+  explicit Snapshot(const char *filename, bool verify_checksum = false);
+  Snapshot(const Snapshot &) = delete;
+  Snapshot &operator=(const Snapshot &) = delete;
+
+  // (atomically replaces filename)
+  static void write(const detail::map_init_t &data, const char *filename);
+
+private:
+  friend struct detail::map_init_t;
+  friend class detail::snapshot_map_ctx_t;
+  friend size_t detail::snapshot_list_size(const Snapshot &, uint32_t);
+  friend uint32_t detail::snapshot_list_item(const Snapshot &, uint32_t, size_t);
+  friend size_t detail::snapshot_map_slots(const Snapshot &, uint32_t);
+  friend bool detail::snapshot_map_slot(const Snapshot &, uint32_t, size_t, std::string_view &, std::string_view &, detail::number_t &, uint32_t &);
+
+  const char *node(uint32_t offset, size_t size) const;   // bounds-checked
+  std::string_view string(uint32_t offset, uint32_t size) const;
+  const detail::snapshot_entry_t *find(uint32_t map, std::string_view key) const;
+
+  MappedFile file;
+  const char *nodes = nullptr, *pool = nullptr;
+  uint32_t nodes_size = 0, pool_size = 0;
+  uint32_t root = 0;
+};
+
+} // namespace Template
+